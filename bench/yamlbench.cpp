@@ -0,0 +1,908 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  yamlbench.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Measures parser and writer throughput over generated corpora. Each corpus
+//  stresses one part of the parser: long plain scalars, quoted scalars and
+//  their escapes, comments, indentation, flow collections or CRLF line ends.
+//  For every corpus size and path, reports MB/s, events/s and heap
+//  allocations per run, as a table or as JSON for tracking regressions. A
+//  path fails if the parser reports other than the events the corpus holds.
+//
+//  Usage: yamlbench [--corpus a,b] [--path a,b] [--size 1K,1M] [--runs n]
+//                   [--json file]
+//
+//  The scanning kernels are measured alone, against the loops they replaced,
+//  when their paths are named, e.g. --path scan,scan-table,scan-loop or
+//  --path classify,classify-loop.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yaml.h"
+
+using namespace PKIsensee;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Heap allocations are counted by replacing the global allocation functions
+
+namespace { // anonymous
+
+std::atomic<size_t> allocationCount{ 0u };
+
+void* Allocate( size_t bytes )
+{
+  allocationCount.fetch_add( 1u, std::memory_order_relaxed );
+  if( void* p = std::malloc( bytes == 0 ? 1 : bytes ) )
+    return p;
+  throw std::bad_alloc();
+}
+
+} // end anonymous namespace
+
+void* operator new( size_t bytes )
+{
+  return Allocate( bytes );
+}
+
+void* operator new[]( size_t bytes )
+{
+  return Allocate( bytes );
+}
+
+void operator delete( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete( void* p, size_t ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p, size_t ) noexcept
+{
+  std::free( p );
+}
+
+namespace { // anonymous
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Corpora
+
+// Deterministic values, so runs are comparable
+class Random
+{
+public:
+  uint32_t Next( uint32_t range )
+  {
+    state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<uint32_t>( state_ >> 33 ) % range;
+  }
+private:
+  uint64_t state_ = 0x2545F4914F6CDD1Dull;
+};
+
+constexpr std::string_view kWords[] =
+{
+  "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+  "india", "juliet", "kilo", "lima", "mike", "november", "oscar", "papa"
+};
+
+std::string_view Word( Random& random )
+{
+  return kWords[ random.Next( static_cast<uint32_t>( std::size( kWords ) ) ) ];
+}
+
+// Appends one record of the corpus; i numbers the record. Returns the number
+// of collection, key and scalar events the parser reports for it.
+using RecordWriter = size_t (*)( std::string&, size_t i, Random& );
+
+size_t FlatRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "key" + std::to_string( i ) + ": " + std::string( Word( random ) ) + '\n';
+  yaml += "count" + std::to_string( i ) + ": " + std::to_string( random.Next( 100000 ) ) + '\n';
+  return 4u;
+}
+
+size_t PlainRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "description" + std::to_string( i ) + ":";
+  for( size_t w = 0; w < 24; ++w )
+  {
+    yaml += ' ';
+    yaml += Word( random );
+    if( w % 6 == 5 ) // ':' and ',' not followed by a space don't end the scalar
+      yaml += " it's 10:30,11:45 at example.com/a-b?q=1";
+  }
+  yaml += '\n';
+  return 2u;
+}
+
+size_t DeepRecord( std::string& yaml, size_t i, Random& random )
+{
+  size_t depth = 1 + i % 24;
+  yaml += "node" + std::to_string( i ) + ":\n";
+  for( size_t level = 1; level < depth; ++level )
+    yaml.append( level * 2, ' ' ).append( "level" + std::to_string( level ) + ":\n" );
+  for( size_t level = depth; level > 0; --level )
+    yaml.append( level * 2, ' ' ).append( "value: " ).append( Word( random ) ).append( "\n" );
+  return depth * 5u; // a mapping, two keys and a scalar per level
+}
+
+size_t FlowRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "list" + std::to_string( i ) + ": [";
+  for( size_t n = 0; n < 48; ++n )
+  {
+    if( n != 0 )
+      yaml += ", ";
+    if( n % 16 == 15 )
+      yaml += "{ name: " + std::string( Word( random ) ) + ", size: " + std::to_string( n ) + " }";
+    else
+      yaml += std::to_string( random.Next( 1000000 ) );
+  }
+  yaml += "]\n";
+  return 66u;
+}
+
+size_t QuotedRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "double" + std::to_string( i ) + ": \"" + std::string( Word( random ) ) +
+          " \\\"quoted\\\"\\tand escaped\\n \\u00e9 " + std::string( Word( random ) ) + "\"\n";
+  yaml += "single" + std::to_string( i ) + ": '" + std::string( Word( random ) ) +
+          " isn''t double quoted: " + std::string( Word( random ) ) + "'\n";
+  return 4u;
+}
+
+size_t CommentRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "# " + std::string( Word( random ) ) + " comment line describing the next key\n";
+  yaml += "setting" + std::to_string( i ) + ": " + std::string( Word( random ) ) +
+          " # trailing comment\n";
+  yaml += "\n";
+  return 2u;
+}
+
+size_t CrlfRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "key" + std::to_string( i ) + ": " + std::string( Word( random ) ) + "\r\n";
+  yaml += "count" + std::to_string( i ) + ": " + std::to_string( random.Next( 100000 ) ) + "\r\n";
+  return 4u;
+}
+
+size_t RecordsRecord( std::string& yaml, size_t i, Random& random )
+{
+  yaml += "- id: " + std::to_string( i ) + '\n';
+  yaml += "  name: " + std::string( Word( random ) ) + '\n';
+  yaml += "  tags: [" + std::string( Word( random ) ) + ", " + std::string( Word( random ) ) + "]\n";
+  yaml += "  owner:\n    team: " + std::string( Word( random ) ) + "\n";
+  return ( i == 0 ) ? 16u : 14u; // the first also counts the start and end of the sequence
+}
+
+struct Corpus
+{
+  std::string_view name;
+  RecordWriter     writeRecord;
+};
+
+constexpr Corpus kCorpora[] =
+{
+  { "flat",     FlatRecord },    // short key/value pairs
+  { "plain",    PlainRecord },   // long plain scalars
+  { "deep",     DeepRecord },    // indentation changes
+  { "flow",     FlowRecord },    // long flow sequences
+  { "quoted",   QuotedRecord },  // quoted scalars with escapes
+  { "comments", CommentRecord }, // comment and blank lines
+  { "crlf",     CrlfRecord },    // CRLF line ends
+  { "records",  RecordsRecord }, // top-level sequence of mappings
+};
+
+// Records are added until the text reaches the size, so it's never cut short
+std::string Generate( const Corpus& corpus, size_t size, size_t& events )
+{
+  std::string yaml;
+  yaml.reserve( size + 1024u );
+  Random random;
+  events = 0u;
+  for( size_t i = 0; yaml.size() < size; ++i )
+    events += corpus.writeRecord( yaml, i, random );
+  return yaml;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Handlers
+
+struct CountingHandler : public YamlStaticHandler
+{
+  size_t events = 0u;
+
+  void onStartSequence() { ++events; }
+  void onEndSequence() { ++events; }
+  void onStartMapping() { ++events; }
+  void onEndMapping() { ++events; }
+  bool onKey( std::string_view ) { ++events; return true; }
+  bool onScalar( std::string_view ) { ++events; return true; }
+};
+
+struct VirtualCountingHandler : public YamlHandler
+{
+  size_t events = 0u;
+
+  void onStartSequence() override { ++events; }
+  void onEndSequence() override { ++events; }
+  void onStartMapping() override { ++events; }
+  void onEndMapping() override { ++events; }
+  bool onKey( std::string_view ) override { ++events; return true; }
+  bool onScalar( std::string_view ) override { ++events; return true; }
+};
+
+// Parser events in the form YamlWriter takes them. The parser reports the keys
+// of "- key: value" entries directly in the sequence, so each entry's mapping
+// is opened here.
+class WriterEvents : public YamlStaticHandler
+{
+public:
+
+  explicit WriterEvents( std::string_view yaml ) : yaml_( yaml ) {}
+
+  enum class Type : uint8_t
+  {
+    BeginMapping,
+    EndMapping,
+    BeginSequence,
+    EndSequence,
+    KeyValue,
+    Scalar
+  };
+
+  struct Event
+  {
+    Type             type = Type::Scalar;
+    std::string_view key;
+    std::string_view text;
+  };
+
+  void onEndDocument() { CloseEntry(); }
+  void onStartSequence() { Begin( Type::BeginSequence, true ); }
+  void onEndSequence() { CloseEntry(); End( Type::EndSequence ); }
+  void onStartMapping() { Begin( Type::BeginMapping, false ); }
+  void onEndMapping() { End( Type::EndMapping ); }
+  void onSequenceEntry() { CloseEntry(); }
+
+  bool onKey( std::string_view key )
+  {
+    if( !stack_.empty() && stack_.back().isSequence )
+    {
+      events_.push_back( { Type::BeginMapping, {}, {} } );
+      stack_.push_back( { false, true } );
+    }
+    key_ = key;
+    return true;
+  }
+
+  bool onScalar( std::string_view scalar )
+  {
+    if( InMapping() )
+      events_.push_back( { Type::KeyValue, key_, Copy( scalar ) } );
+    else
+      events_.push_back( { Type::Scalar, {}, Copy( scalar ) } );
+    return true;
+  }
+
+  const std::vector<Event>& GetEvents() const
+  {
+    return events_;
+  }
+
+private:
+
+  struct Frame
+  {
+    bool isSequence = false;
+    bool isEntry = false;
+  };
+
+  // The root mapping isn't reported by the parser
+  bool InMapping() const
+  {
+    return stack_.empty() || !stack_.back().isSequence;
+  }
+
+  void Begin( Type type, bool isSequence )
+  {
+    events_.push_back( { type, InMapping() ? key_ : std::string_view{}, {} } );
+    stack_.push_back( { isSequence, false } );
+  }
+
+  void End( Type type )
+  {
+    events_.push_back( { type, {}, {} } );
+    if( !stack_.empty() )
+      stack_.pop_back();
+  }
+
+  void CloseEntry()
+  {
+    if( !stack_.empty() && stack_.back().isEntry )
+      End( Type::EndMapping );
+  }
+
+  // Decoded escapes don't outlive the callback
+  std::string_view Copy( std::string_view scalar )
+  {
+    if( scalar.data() >= yaml_.data() && scalar.data() < yaml_.data() + yaml_.size() )
+      return scalar;
+    return copies_.emplace_back( scalar );
+  }
+
+private:
+
+  std::string_view        yaml_;
+  std::vector<Event>      events_;
+  std::vector<Frame>      stack_;
+  std::string_view        key_;
+  std::deque<std::string> copies_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Measurements
+
+struct Sample
+{
+  double seconds = 0.0;
+  size_t events = 0u;
+  size_t allocations = 0u;
+  bool   isValid = true;
+};
+
+struct Result
+{
+  size_t events = 0u;
+  bool   isValid = false;
+};
+
+// Runs the path reps times; the corpus is passed as text and as a file
+using PathRunner = Sample (*)( std::string_view yaml, const std::filesystem::path& file, size_t reps );
+
+template <typename Fn>
+Sample Measure( size_t reps, Fn&& fn )
+{
+  Sample sample;
+  auto allocations = allocationCount.load( std::memory_order_relaxed );
+  auto start = std::chrono::steady_clock::now();
+  for( size_t r = 0; r < reps; ++r )
+  {
+    auto [ events, isValid ] = fn();
+    sample.events += events;
+    sample.isValid = sample.isValid && isValid;
+  }
+  sample.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+  sample.allocations = allocationCount.load( std::memory_order_relaxed ) - allocations;
+  return sample;
+}
+
+Sample RunVirtual( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    VirtualCountingHandler handler;
+    YamlParser parser( yaml, handler );
+    bool isValid = parser.Parse();
+    return Result{ handler.events, isValid };
+  } );
+}
+
+Sample RunStatic( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    CountingHandler handler;
+    BasicYamlParser<CountingHandler> parser( yaml, handler );
+    bool isValid = parser.Parse();
+    return Result{ handler.events, isValid };
+  } );
+}
+
+Sample RunIndex( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    CountingHandler handler;
+    BasicYamlParser<CountingHandler> parser( yaml, handler );
+    parser.UseStructuralIndex( true );
+    bool isValid = parser.Parse();
+    return Result{ handler.events, isValid };
+  } );
+}
+
+// One parser reused for every run, as for many small documents
+Sample RunReset( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  CountingHandler handler;
+  BasicYamlParser<CountingHandler> parser( yaml, handler );
+  parser.Parse(); // the first parse sizes the internal buffers
+  return Measure( reps, [&]()
+  {
+    handler.events = 0u;
+    parser.Reset( yaml );
+    bool isValid = parser.Parse();
+    return Result{ handler.events, isValid };
+  } );
+}
+
+Sample RunChunked( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    CountingHandler handler;
+    BasicYamlParser<CountingHandler> parser( yaml, handler );
+    bool isValid = parser.ParseChunked();
+    return Result{ handler.events, isValid };
+  } );
+}
+
+// Events are counted as nodes, since the builder is internal
+size_t CountNodes( const YamlNode& node )
+{
+  size_t count = 1u;
+  for( const auto& child : node.GetChildren() )
+    count += CountNodes( child );
+  return count;
+}
+
+Sample RunDocument( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    YamlDocument document;
+    bool isValid = document.Parse( yaml );
+    return Result{ isValid ? CountNodes( document.GetRoot() ) : 0u, isValid };
+  } );
+}
+
+Sample RunRead( std::string_view, const std::filesystem::path& file, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    std::ifstream stream( file, std::ios::binary );
+    std::string yaml( std::istreambuf_iterator<char>( stream ), {} );
+    CountingHandler handler;
+    BasicYamlParser<CountingHandler> parser( yaml, handler );
+    bool isValid = parser.Parse();
+    return Result{ handler.events, isValid };
+  } );
+}
+
+Sample RunMap( std::string_view, const std::filesystem::path& file, size_t reps )
+{
+  return Measure( reps, [&]()
+  {
+    CountingHandler handler;
+    bool isValid = BasicYamlParser<CountingHandler>::ParseFile( file, handler );
+    return Result{ handler.events, isValid };
+  } );
+}
+
+// Writes the events of the corpus, recorded beforehand, so only the writer is
+// measured. Throughput is relative to the size of the corpus.
+Sample RunWriter( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  WriterEvents recorded( yaml );
+  BasicYamlParser<WriterEvents> parser( yaml, recorded );
+  if( !parser.Parse() )
+    return Sample{ 0.0, 0u, 0u, false };
+  std::string output;
+  output.reserve( yaml.size() * 2 );
+  return Measure( reps, [&]()
+  {
+    output.clear();
+    YamlWriter writer( std::back_inserter( output ) );
+    for( const auto& event : recorded.GetEvents() )
+    {
+      switch( event.type )
+      {
+      case WriterEvents::Type::BeginMapping:  writer.BeginMapping( event.key );  break;
+      case WriterEvents::Type::EndMapping:    writer.EndMapping();               break;
+      case WriterEvents::Type::BeginSequence: writer.BeginSequence( event.key ); break;
+      case WriterEvents::Type::EndSequence:   writer.EndSequence();              break;
+      case WriterEvents::Type::KeyValue:      writer.KeyValue( event.key, event.text ); break;
+      case WriterEvents::Type::Scalar:        writer.Scalar( event.text );       break;
+      }
+    }
+    return Result{ recorded.GetEvents().size(), !output.empty() };
+  } );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Scanning kernels, measured alone over the whole corpus. Each is paired with
+// the byte loop it replaced, and both must find the same characters; the
+// characters found are counted as events.
+
+// The parser's classification before the lookup table: a linear search of a
+// small array for every character
+template <size_t N>
+bool CharIsIn( char c, const std::array<char, N>& chars )
+{
+  return std::any_of( chars.begin(), chars.end(), [c]( char e ) { return c == e; } );
+}
+
+using Finder = const char* (*)( const char* curr, const char* end );
+using Kernel = size_t (*)( std::string_view );
+
+template <Finder find>
+size_t CountFound( std::string_view yaml )
+{
+  size_t found = 0u;
+  const char* end = yaml.data() + yaml.size();
+  for( const char* curr = yaml.data(); ( curr = find( curr, end ) ) < end; ++curr )
+    ++found;
+  return found;
+}
+
+// ParsePlain's search for a character that may end the scalar, before SSE2
+const char* FindEndScalarLoop( const char* curr, const char* end )
+{
+  for( ; curr < end; ++curr )
+  {
+    if( CharIsIn( *curr, Yaml::Detail::kEndScalar ) )
+      return curr;
+  }
+  return end;
+}
+
+// The same search with the lookup table, one character at a time
+const char* FindEndScalarTable( const char* curr, const char* end )
+{
+  for( ; curr < end; ++curr )
+  {
+    if( Yaml::Detail::IsCharClass( *curr, Yaml::Detail::kEndScalarClass ) )
+      return curr;
+  }
+  return end;
+}
+
+// Every character classified as GetIndent, SkipLine and IsNormalChar do
+size_t Classify( std::string_view yaml )
+{
+  using namespace Yaml::Detail;
+  size_t found = 0u;
+  for( char c : yaml )
+  {
+    found += IsCharClass( c, kIndentClass );
+    found += IsCharClass( c, kIgnoreLineClass );
+    found += IsCharClass( c, kEndLineClass );
+    found += IsCharClass( c, kWhiteClass );
+  }
+  return found;
+}
+
+// The same, with the sets those functions searched before the lookup table
+size_t ClassifyLoop( std::string_view yaml )
+{
+  size_t found = 0u;
+  for( char c : yaml )
+  {
+    found += CharIsIn( c, std::array{ ' ', '-' } );
+    found += CharIsIn( c, std::array{ '\r', '\n', '#' } );
+    found += CharIsIn( c, std::array{ '\r', '\n' } );
+    found += CharIsIn( c, std::array{ ' ', '\r', '\n', '\0' } );
+  }
+  return found;
+}
+
+// Runs the kernel, checking that it finds what the kernel it's compared with does
+Sample MeasureKernel( std::string_view yaml, size_t reps, Kernel kernel, Kernel reference )
+{
+  size_t expected = reference( yaml );
+  return Measure( reps, [&]()
+  {
+    size_t found = kernel( yaml );
+    return Result{ found, found == expected };
+  } );
+}
+
+Sample RunScan( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return MeasureKernel( yaml, reps, CountFound<Yaml::Detail::FindEndScalar>, CountFound<FindEndScalarLoop> );
+}
+
+Sample RunScanTable( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return MeasureKernel( yaml, reps, CountFound<FindEndScalarTable>, CountFound<FindEndScalarLoop> );
+}
+
+Sample RunScanLoop( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return MeasureKernel( yaml, reps, CountFound<FindEndScalarLoop>, CountFound<Yaml::Detail::FindEndScalar> );
+}
+
+Sample RunClassify( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return MeasureKernel( yaml, reps, Classify, ClassifyLoop );
+}
+
+Sample RunClassifyLoop( std::string_view yaml, const std::filesystem::path&, size_t reps )
+{
+  return MeasureKernel( yaml, reps, ClassifyLoop, Classify );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct Path
+{
+  std::string_view name;
+  PathRunner       run;
+  bool             isParserEvents; // the events counted are the parser's, checked against the corpus
+};
+
+constexpr Path kPaths[] =
+{
+  { "virtual", RunVirtual,  true },  // YamlParser, calling YamlHandler through its vtable
+  { "static",  RunStatic,   true },  // BasicYamlParser with a concrete handler type
+  { "index",   RunIndex,    true },  // the same with the structural index
+  { "reset",   RunReset,    true },  // one parser reused through Reset()
+  { "chunked", RunChunked,  true },  // ParseChunked on all hardware threads
+  { "dom",     RunDocument, false }, // building a YamlDocument
+  { "read",    RunRead,     true },  // reading the file into a string, then parsing
+  { "mmap",    RunMap,      true },  // parsing the file from a memory mapping
+  { "writer",  RunWriter,   false }, // YamlWriter writing the corpus' events
+
+  // Kernels, only run when named
+  { "scan",          RunScan,         false }, // FindEndScalar, in 16-byte SSE2 blocks
+  { "scan-table",    RunScanTable,    false }, // the same search with the lookup table
+  { "scan-loop",     RunScanLoop,     false }, // the byte loop both replaced
+  { "classify",      RunClassify,     false }, // GetIndent, SkipLine and IsNormalChar's lookups
+  { "classify-loop", RunClassifyLoop, false }, // the set searches the lookup table replaced
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Command line
+
+struct Options
+{
+  std::vector<const Corpus*> corpora;
+  std::vector<const Path*>   paths;
+  std::vector<size_t>        sizes;
+  size_t                     runs = 5u;
+  std::string                jsonFile;
+};
+
+std::vector<std::string_view> SplitList( std::string_view list )
+{
+  std::vector<std::string_view> items;
+  while( !list.empty() )
+  {
+    auto comma = list.find( ',' );
+    items.push_back( list.substr( 0, comma ) );
+    list = ( comma == std::string_view::npos ) ? std::string_view{} : list.substr( comma + 1 );
+  }
+  return items;
+}
+
+// Sizes in bytes, with an optional K, M or G suffix, e.g. "64K"
+bool ParseSize( std::string_view text, size_t& size )
+{
+  size_t multiplier = 1u;
+  if( !text.empty() )
+  {
+    switch( text.back() )
+    {
+    case 'K': case 'k': multiplier = size_t( 1 ) << 10; break;
+    case 'M': case 'm': multiplier = size_t( 1 ) << 20; break;
+    case 'G': case 'g': multiplier = size_t( 1 ) << 30; break;
+    default: break;
+    }
+    if( multiplier != 1u )
+      text.remove_suffix( 1 );
+  }
+  size_t value = 0u;
+  auto [ ptr, ec ] = std::from_chars( text.data(), text.data() + text.size(), value );
+  if( ec != std::errc() || ptr != text.data() + text.size() || value == 0u )
+    return false;
+  size = value * multiplier;
+  return true;
+}
+
+template <typename T, size_t N>
+bool Select( std::string_view list, const T ( &all )[ N ], std::vector<const T*>& selected )
+{
+  for( auto name : SplitList( list ) )
+  {
+    auto it = std::find_if( std::begin( all ), std::end( all ), [&]( const T& t ) { return t.name == name; } );
+    if( it == std::end( all ) )
+    {
+      std::fprintf( stderr, "Unknown name: %.*s\n", static_cast<int>( name.size() ), name.data() );
+      return false;
+    }
+    selected.push_back( &*it );
+  }
+  return true;
+}
+
+bool ParseOptions( int argc, char** argv, Options& options )
+{
+  for( int i = 1; i < argc; ++i )
+  {
+    std::string_view arg( argv[ i ] );
+    if( i + 1 == argc )
+      return false;
+    std::string_view value( argv[ ++i ] );
+    if( arg == "--corpus" )
+    {
+      if( !Select( value, kCorpora, options.corpora ) )
+        return false;
+    }
+    else if( arg == "--path" )
+    {
+      if( !Select( value, kPaths, options.paths ) )
+        return false;
+    }
+    else if( arg == "--size" )
+    {
+      for( auto item : SplitList( value ) )
+      {
+        size_t size = 0u;
+        if( !ParseSize( item, size ) )
+          return false;
+        options.sizes.push_back( size );
+      }
+    }
+    else if( arg == "--runs" )
+    {
+      if( !ParseSize( value, options.runs ) )
+        return false;
+    }
+    else if( arg == "--json" )
+    {
+      options.jsonFile = value;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  // Defaults: everything, at sizes quick enough to run routinely
+  if( options.corpora.empty() )
+    Select( "flat,plain,deep,flow,quoted,comments,crlf,records", kCorpora, options.corpora );
+  if( options.paths.empty() )
+    Select( "virtual,static,index,reset,chunked,dom,read,mmap,writer", kPaths, options.paths );
+  if( options.sizes.empty() )
+    options.sizes = { size_t( 1 ) << 10, size_t( 64 ) << 10, size_t( 1 ) << 20 };
+  return true;
+}
+
+struct Measurement
+{
+  std::string_view corpus;
+  std::string_view path;
+  size_t           bytes = 0u;
+  size_t           reps = 0u;   // runs of the path in each sample
+  double           seconds = 0.0; // per run, best of the samples
+  double           events = 0.0;  // per run
+  double           allocations = 0.0; // per run
+  bool             isValid = true;
+};
+
+void WriteJson( std::FILE* file, const std::vector<Measurement>& measurements )
+{
+  std::fprintf( file, "{\n  \"results\": [\n" );
+  for( size_t i = 0; i < measurements.size(); ++i )
+  {
+    const auto& m = measurements[ i ];
+    std::fprintf( file, "    { \"corpus\": \"%.*s\", \"path\": \"%.*s\", \"bytes\": %zu, \"seconds\": %.9g, "
+                  "\"mb_per_s\": %.3f, \"events_per_s\": %.0f, \"events\": %.0f, \"allocations\": %.1f, "
+                  "\"valid\": %s }%s\n",
+                  static_cast<int>( m.corpus.size() ), m.corpus.data(),
+                  static_cast<int>( m.path.size() ), m.path.data(),
+                  m.bytes, m.seconds, m.bytes / m.seconds / 1e6, m.events / m.seconds, m.events,
+                  m.allocations, m.isValid ? "true" : "false",
+                  ( i + 1 == measurements.size() ) ? "" : "," );
+  }
+  std::fprintf( file, "  ]\n}\n" );
+}
+
+} // end anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main( int argc, char** argv )
+{
+  Options options;
+  if( !ParseOptions( argc, argv, options ) )
+  {
+    std::fprintf( stderr, "Usage: yamlbench [--corpus a,b] [--path a,b] [--size 1K,1M] [--runs n] [--json file]\n" );
+    return EXIT_FAILURE;
+  }
+
+  // Each sample runs the path enough times to be timed reliably
+  constexpr size_t kMinSampleBytes = size_t( 4 ) << 20;
+  auto file = std::filesystem::temp_directory_path() / "yamlbench.yaml";
+  std::vector<Measurement> measurements;
+  bool isAllValid = true;
+  std::printf( "%-9s %-13s %10s %10s %14s %12s\n", "corpus", "path", "bytes", "MB/s", "events/s", "allocs/run" );
+  for( const auto* corpus : options.corpora )
+  {
+    for( size_t size : options.sizes )
+    {
+      size_t events = 0u;
+      auto yaml = Generate( *corpus, size, events );
+      std::ofstream( file, std::ios::binary ).write( yaml.data(), static_cast<std::streamsize>( yaml.size() ) );
+      size_t reps = std::max( size_t( 1 ), kMinSampleBytes / yaml.size() );
+      for( const auto* path : options.paths )
+      {
+        Measurement m{ corpus->name, path->name, yaml.size(), reps };
+        m.seconds = 1e300;
+        for( size_t run = 0; run < options.runs; ++run )
+        {
+          auto sample = path->run( yaml, file, reps );
+          m.isValid = m.isValid && sample.isValid &&
+                      ( !path->isParserEvents || sample.events == events * reps );
+          m.seconds = std::min( m.seconds, sample.seconds / static_cast<double>( reps ) );
+          m.events = static_cast<double>( sample.events ) / static_cast<double>( reps );
+          m.allocations = static_cast<double>( sample.allocations ) / static_cast<double>( reps );
+        }
+        isAllValid = isAllValid && m.isValid;
+        std::printf( "%-9.*s %-13.*s %10zu %10.1f %14.0f %12.1f%s\n",
+                     static_cast<int>( m.corpus.size() ), m.corpus.data(),
+                     static_cast<int>( m.path.size() ), m.path.data(),
+                     m.bytes, m.bytes / m.seconds / 1e6, m.events / m.seconds, m.allocations,
+                     m.isValid ? "" : " (failed)" );
+        measurements.push_back( m );
+      }
+    }
+  }
+  std::filesystem::remove( file );
+
+  if( !options.jsonFile.empty() )
+  {
+    std::FILE* json = std::fopen( options.jsonFile.c_str(), "w" );
+    if( json == nullptr )
+    {
+      std::fprintf( stderr, "Can't write %s\n", options.jsonFile.c_str() );
+      return EXIT_FAILURE;
+    }
+    WriteJson( json, measurements );
+    std::fclose( json );
+  }
+  return isAllValid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
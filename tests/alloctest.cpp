@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  alloctest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that parsers reused through Reset() or a BasicYamlParserPool don't
+//  allocate once their buffers have grown to fit, counting heap allocations
+//  with replacement allocation functions.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+std::atomic<size_t> allocationCount{ 0u };
+
+void* Allocate( size_t bytes )
+{
+  allocationCount.fetch_add( 1u, std::memory_order_relaxed );
+  if( void* p = std::malloc( bytes == 0 ? 1 : bytes ) )
+    return p;
+  throw std::bad_alloc();
+}
+
+} // end anonymous namespace
+
+void* operator new( size_t bytes )
+{
+  return Allocate( bytes );
+}
+
+void* operator new[]( size_t bytes )
+{
+  return Allocate( bytes );
+}
+
+void operator delete( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete( void* p, size_t ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p, size_t ) noexcept
+{
+  std::free( p );
+}
+
+namespace { // anonymous
+
+// Small documents using escapes, anchors, block scalars and errors, each of
+// which uses an internal buffer of the parser
+constexpr std::string_view kDocuments[] =
+{
+  "a: 1\nb: [ x, \"y\\tz\" ]\n",
+  "- 1\n- 2\n",
+  "k: &a { p: q }\nr: *a\n",
+  "bad: [\n",
+  "a:\n  b:\n    c: 'd'\n",
+  "b: |\n  l\n  m\n",
+  "t: !!str tagged\n",
+  "q: \"unterminated\n"
+};
+
+struct StaticHandler : public YamlStaticHandler
+{
+  size_t scalars = 0u;
+
+  bool onScalar( std::string_view )
+  {
+    ++scalars;
+    return true;
+  }
+};
+
+struct VirtualHandler : public YamlHandler
+{
+  size_t scalars = 0u;
+
+  bool onScalar( std::string_view ) override
+  {
+    ++scalars;
+    return true;
+  }
+  void onError( std::string_view, size_t, size_t ) override {}
+};
+
+void TestReset()
+{
+  for( auto yaml : kDocuments )
+  {
+    StaticHandler handler;
+    BasicYamlParser<StaticHandler> parser( yaml, handler );
+    parser.Parse();
+    parser.Reset( yaml );
+    parser.Parse();
+
+    auto allocations = allocationCount.load();
+    for( int i = 0; i < 100; ++i )
+    {
+      parser.Reset( yaml );
+      parser.Parse();
+    }
+    YAML_CHECK( allocationCount.load() == allocations );
+  }
+}
+
+void TestPool()
+{
+  YamlParserPool pool;
+  VirtualHandler handler;
+  for( int i = 0; i < 3; ++i )
+  {
+    for( auto yaml : kDocuments )
+      pool.Acquire( yaml, handler )->Parse();
+  }
+
+  auto allocations = allocationCount.load();
+  for( int i = 0; i < 1000; ++i )
+  {
+    for( auto yaml : kDocuments )
+      pool.Acquire( yaml, handler )->Parse();
+  }
+  YAML_CHECK( allocationCount.load() == allocations );
+  YAML_CHECK( handler.scalars != 0u );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestReset();
+  TestPool();
+  return YamlTest::GetExitCode();
+}
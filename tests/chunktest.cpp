@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  chunktest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that ParseChunked reports the same events, at the same positions,
+//  as Parse, and that YamlDocument builds the same tree either way.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+void CheckSame( std::string_view yaml )
+{
+  bool isParsed = false;
+  auto expected = YamlTest::GetTranscript( yaml, true, 1, &isParsed );
+  for( size_t threadCount : { 2u, 4u, 8u } )
+  {
+    bool isChunkParsed = !isParsed;
+    YAML_CHECK( YamlTest::GetTranscript( yaml, true, threadCount, &isChunkParsed ) == expected );
+    YAML_CHECK( isChunkParsed == isParsed );
+  }
+}
+
+void CheckSameDocument( std::string_view yaml )
+{
+  YamlDocument sequential;
+  YamlDocument chunked;
+  YAML_CHECK( sequential.Parse( yaml, 1 ) );
+  YAML_CHECK( chunked.Parse( yaml, 4 ) );
+  YAML_CHECK( YamlTest::GetTree( chunked.GetRoot() ) == YamlTest::GetTree( sequential.GetRoot() ) );
+}
+
+void TestEvents()
+{
+  for( bool isSequence : { false, true } )
+  {
+    for( bool isCrlf : { false, true } )
+      CheckSame( YamlTest::MakeDocument( 3000, isSequence, isCrlf ) );
+  }
+}
+
+void TestUnsplittable()
+{
+  // An alias to an anchor in another piece
+  auto yaml = "first: &a shared\n" + YamlTest::MakeDocument( 3000, false ) + "last: *a\n";
+  CheckSame( yaml );
+
+  // A flow collection spanning a split
+  yaml = YamlTest::MakeDocument( 1500, false ) + "flow: [\n";
+  for( int i = 0; i < 20000; ++i )
+    yaml.append( "x" ).append( std::to_string( i ) ).append( ": 1,\n" );
+  yaml += "]\n";
+  yaml += YamlTest::MakeDocument( 1500, false );
+  CheckSame( yaml );
+
+  // Errors are reported by Parse()
+  CheckSame( YamlTest::MakeDocument( 3000, true ) + "- [ unterminated\n" );
+  CheckSame( YamlTest::MakeDocument( 3000, false ) + "bad:\n\ttab: 1\n" );
+
+  // Parsing resumes within the text, after the pieces already delivered
+  CheckSame( YamlTest::MakeDocument( 1500, false ) + "bad:\n\ttab: 1\n" + YamlTest::MakeDocument( 1500, false ) );
+  CheckSame( "- first: &a shared\n" + YamlTest::MakeDocument( 1500, true ) + "- middle: *a\n" +
+             YamlTest::MakeDocument( 1500, true ) );
+  CheckSame( YamlTest::MakeDocument( 1500, false ) + "open:\n  nested:\n    deep: *missing\n" +
+             YamlTest::MakeDocument( 1500, false ) );
+}
+
+// Pieces are indexed when the parser uses the structural index
+void TestStructuralIndex()
+{
+  for( bool isSequence : { false, true } )
+  {
+    auto yaml = YamlTest::MakeDocument( 3000, isSequence );
+    YamlTest::TranscriptHandler handler;
+    BasicYamlParser<YamlTest::TranscriptHandler> parser( yaml, handler );
+    handler.SetParser( parser );
+    parser.UseStructuralIndex( true );
+    YAML_CHECK( parser.ParseChunked( 4 ) );
+    YAML_CHECK( handler.GetTranscript() == YamlTest::GetTranscript( yaml, true ) );
+  }
+}
+
+// Tagged scalars are decoded once each, as their events are delivered
+void TestTags()
+{
+  std::string yaml;
+  for( size_t i = 0; i < 10000; ++i )
+    yaml.append( "key" ).append( std::to_string( i ) ).append( ": !count " ).append( std::to_string( i ) ).append( "\n" );
+
+  struct TaggedHandler : public YamlStaticHandler
+  {
+    size_t taggedCount = 0u;
+    void onTagged( std::string_view, const Yaml::TaggedValue& )
+    {
+      ++taggedCount;
+    }
+  };
+
+  YamlTagRegistry registry;
+  size_t decodeCount = 0u;
+  registry.Add( "!count", [&decodeCount]( std::string_view, Yaml::TaggedValue& )
+  {
+    ++decodeCount;
+    return true;
+  } );
+  TaggedHandler handler;
+  BasicYamlParser<TaggedHandler> parser( yaml, handler );
+  parser.SetTagRegistry( &registry );
+  YAML_CHECK( parser.ParseChunked( 4 ) );
+  YAML_CHECK( decodeCount == 10000u && handler.taggedCount == 10000u );
+}
+
+void TestDocument()
+{
+  CheckSameDocument( YamlTest::MakeDocument( 3000, false ) );
+  CheckSameDocument( YamlTest::MakeDocument( 3000, true ) );
+
+  // Each record of a top-level sequence is a mapping of its own
+  std::string yaml = YamlTest::MakeDocument( 3000, true );
+  YamlDocument records;
+  YAML_CHECK( records.Parse( yaml, 4 ) );
+  auto roots = records.GetRoot().GetChildren();
+  YAML_CHECK( roots.size() == 1u && roots[ 0 ].GetChildren().size() == 3000u );
+  for( const auto& record : roots[ 0 ].GetChildren() )
+  {
+    YAML_CHECK( record.type == YamlNode::Type::Mapping && record.GetChildren().size() == 7u );
+    const auto* list = record.Find( "list" );
+    YAML_CHECK( list != nullptr && list->GetChildren().size() == 2u );
+  }
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestEvents();
+  TestUnsplittable();
+  TestStructuralIndex();
+  TestTags();
+  TestDocument();
+  return YamlTest::GetExitCode();
+}
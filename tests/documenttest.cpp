@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  documenttest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the tree YamlDocument builds from YAML text.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Each entry of a block sequence of mappings is a node of its own
+void TestDocument()
+{
+  std::string_view yaml = "servers:\n  - name: a\n    port: 1\n  - name: b\n    owner:\n      team: c\n"
+                          "  - d\n  - &e name: e\n  - - f\n    - g: 1\n      h: 2\nlast: *e\n";
+  YamlDocument document;
+  YAML_CHECK( document.Parse( yaml ) );
+  YAML_CHECK( YamlTest::GetTree( document.GetRoot() ) ==
+              "{servers: [{name: a port: 1} {name: b owner: {team: c}} d {name: e} [f {g: 1 h: 2}]] last: name}" );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestDocument();
+  return YamlTest::GetExitCode();
+}
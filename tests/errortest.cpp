@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  errortest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the errors the parser reports: their codes, offsets and positions,
+//  the text formatted into the error's fixed buffer, and the forwarding of
+//  YamlHandler::onErrorCode to onError.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Keeps the first error reported, including its detail and text as formatted
+struct ErrorHandler : public YamlStaticHandler
+{
+  void onErrorCode( const YamlError& error )
+  {
+    if( errorCount++ != 0 )
+      return;
+    first = error;
+    detail = error.detail;
+    auto errorText = error.GetText();
+    text = errorText;
+    isTerminated = ( errorText.data()[ errorText.size() ] == '\0' );
+  }
+
+  YamlError   first;   // detail isn't valid after the callback
+  std::string detail;
+  std::string text;
+  bool        isTerminated = false;
+  size_t      errorCount = 0u;
+};
+
+// Overrides only the message form of the callback
+struct MessageHandler : public YamlHandler
+{
+  void onError( std::string_view message, size_t errLine, size_t errCol ) override
+  {
+    text = message;
+    line = errLine;
+    col = errCol;
+  }
+
+  std::string text;
+  size_t      line = 0u;
+  size_t      col = 0u;
+};
+
+bool GetError( std::string_view yaml, ErrorHandler& handler )
+{
+  BasicYamlParser<ErrorHandler> parser( yaml, handler );
+  return !parser.Parse() && handler.errorCount == 1u;
+}
+
+// The offset locates the error in the text along with its line and column
+void TestOffsets()
+{
+  ErrorHandler tab;
+  YAML_CHECK( GetError( "a: 1\n\tb: 2\n", tab ) );
+  YAML_CHECK( tab.first.code == YamlErrorCode::Tab );
+  YAML_CHECK( tab.first.offset == 5u && tab.first.line == 2u && tab.first.col == 1u );
+
+  ErrorHandler escape;
+  YAML_CHECK( GetError( "a: 1\nbb: \"x\\q\"\n", escape ) );
+  YAML_CHECK( escape.first.code == YamlErrorCode::InvalidEscape );
+  YAML_CHECK( escape.first.offset == 11u && escape.first.line == 2u && escape.first.col == 7u );
+  YAML_CHECK( escape.text == "Invalid escape sequence <\\q>" && escape.isTerminated );
+}
+
+// Details too long for the buffer are cut short, keeping the suffix
+void TestTruncation()
+{
+  std::string alias( 300, 'n' );
+  ErrorHandler handler;
+  YAML_CHECK( GetError( "a: &x 1\nb: *" + alias + "\n", handler ) );
+  YAML_CHECK( handler.first.code == YamlErrorCode::UnknownAlias );
+  YAML_CHECK( handler.detail == alias );
+  YAML_CHECK( handler.text.size() == 127u && handler.isTerminated );
+  YAML_CHECK( handler.text.starts_with( "Unknown alias <nnn" ) && handler.text.ends_with( "nnn>" ) );
+
+  // Short details are complete
+  ErrorHandler shortHandler;
+  YAML_CHECK( GetError( "a: *b\n", shortHandler ) );
+  YAML_CHECK( shortHandler.text == "Unknown alias <b>" && shortHandler.isTerminated );
+}
+
+// Handlers overriding only onError receive the formatted text and position
+void TestForwarding()
+{
+  MessageHandler handler;
+  YamlParser parser( "a: 1\nb: 'x\n", handler );
+  YAML_CHECK( !parser.Parse() );
+  YAML_CHECK( handler.text == "Unterminated quoted scalar <'x\n...>" );
+  YAML_CHECK( handler.line == 2u && handler.col == 4u );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestOffsets();
+  TestTruncation();
+  TestForwarding();
+  return YamlTest::GetExitCode();
+}
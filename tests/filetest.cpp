@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  filetest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that text ending without a line end, in indentation or in a quoted
+//  scalar is parsed without reading beyond the end of the text, whether in
+//  memory or in a file mapped by ParseFile.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Text ending in indentation or a quoted scalar, with nothing readable beyond
+// the end of the buffer
+void TestTextEnd()
+{
+  constexpr std::string_view kDocuments[] = { "a: 1\n  ", "a: 'x'", "- \"x\"", "a:\n  " };
+  for( auto yaml : kDocuments )
+  {
+    auto buffer = std::make_unique<char[]>( yaml.size() );
+    std::memcpy( buffer.get(), yaml.data(), yaml.size() );
+    YamlTest::TranscriptHandler handler;
+    BasicYamlParser<YamlTest::TranscriptHandler> parser( std::string_view( buffer.get(), yaml.size() ), handler );
+    YAML_CHECK( parser.Parse() );
+  }
+}
+
+// Parses the text from a temporary file through ParseFile, checking that it
+// reports the events parsing the text in memory reports
+void CheckFile( const std::string& yaml )
+{
+  auto path = std::filesystem::temp_directory_path() / "yaml_filetest.yaml";
+  {
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( yaml.data(), static_cast<std::streamsize>( yaml.size() ) );
+  }
+  YAML_CHECK( std::filesystem::file_size( path ) == yaml.size() );
+
+  YamlTest::TranscriptHandler handler;
+  YAML_CHECK( BasicYamlParser<YamlTest::TranscriptHandler>::ParseFile( path, handler ) );
+  YAML_CHECK( handler.GetTranscript() == YamlTest::GetTranscript( yaml ) );
+  std::filesystem::remove( path );
+}
+
+void TestParseFile()
+{
+  CheckFile( "" );
+  CheckFile( "a: 1\nb: [ x, y ]" ); // no final line end
+  CheckFile( "a:\n  b: 1\n  " );
+
+  // A size that is a multiple of any common page size, so the mapping ends at
+  // a page boundary, with the final scalar ending there too
+  constexpr size_t kFileSize = 64u * 1024u;
+  std::string yaml;
+  for( size_t i = 0; yaml.size() < kFileSize - 64u; ++i )
+    yaml.append( "key" ).append( std::to_string( i ) ).append( ": value\n" );
+  yaml.append( "last: " );
+  yaml.append( kFileSize - yaml.size(), 'x' );
+  YAML_CHECK( yaml.size() == kFileSize );
+  CheckFile( yaml );
+
+  // Files that can't be opened are reported as errors
+  YamlTest::TranscriptHandler missingHandler;
+  auto missing = std::filesystem::temp_directory_path() / "yaml_filetest_missing" / "missing.yaml";
+  YAML_CHECK( !BasicYamlParser<YamlTest::TranscriptHandler>::ParseFile( missing, missingHandler ) );
+  YAML_CHECK( missingHandler.hasError && missingHandler.errorCode == YamlErrorCode::FileOpen );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestTextEnd();
+  TestParseFile();
+  return YamlTest::GetExitCode();
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  indextest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that the structural index finds the characters FindEndScalar finds,
+//  and that parsing with it reports the events parsing without it reports.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Every search, from every position to the end and to a nearer end
+void CheckSameEnds( std::string_view text )
+{
+  Yaml::Detail::StructuralIndex index;
+  index.Build( text );
+  YAML_CHECK( index.IsBuilt() );
+  const char* end = text.data() + text.size();
+  for( const char* curr = text.data(); curr <= end; ++curr )
+  {
+    YAML_CHECK( index.FindNext( curr, end ) == Yaml::Detail::FindEndScalar( curr, end ) );
+    const char* nearEnd = curr + ( end - curr ) / 2;
+    YAML_CHECK( index.FindNext( curr, nearEnd ) == Yaml::Detail::FindEndScalar( curr, nearEnd ) );
+  }
+}
+
+void TestFindNext()
+{
+  CheckSameEnds( "" );
+  CheckSameEnds( "a" );
+  CheckSameEnds( "key: value, [x]\n{y} # z\r\n\t" );
+
+  // Terminators on both sides of the 64-bit word boundaries, and none at all
+  std::string text( 200, 'x' );
+  for( size_t pos : { 0u, 62u, 63u, 64u, 65u, 127u, 128u, 199u } )
+    text[ pos ] = ':';
+  CheckSameEnds( text );
+  CheckSameEnds( std::string( 130, 'x' ) );
+
+  // Characters with the high bit set aren't terminators
+  CheckSameEnds( "caf\xC3\xA9: \xE2\x80\xA8\xFF,\x80]" );
+  CheckSameEnds( YamlTest::MakeDocument( 3, true ) );
+
+  YAML_CHECK( !Yaml::Detail::StructuralIndex().IsBuilt() );
+}
+
+std::string GetIndexedTranscript( std::string_view yaml )
+{
+  YamlTest::TranscriptHandler handler;
+  BasicYamlParser<YamlTest::TranscriptHandler> parser( yaml, handler );
+  handler.SetParser( parser );
+  parser.UseStructuralIndex( true );
+  parser.Parse();
+  return handler.GetTranscript();
+}
+
+void CheckSame( std::string_view yaml )
+{
+  YAML_CHECK( GetIndexedTranscript( yaml ) == YamlTest::GetTranscript( yaml, true ) );
+}
+
+void TestEvents()
+{
+  CheckSame( "" );
+  CheckSame( "a: 1" );
+  CheckSame( "a: plain text # comment\nb: [ x, y: z, { k: v } ]\nc: 'q: r'\nd: |\n  e: f\n" );
+  CheckSame( "a: b:c\nurl: http://x.com/a,b\n- not: [a, list\n" ); // includes an error
+  CheckSame( "a: 1\r\nb:\r\n  - 2\r\n  - \"3\"\r\n" );
+  CheckSame( YamlTest::MakeDocument( 200, false ) );
+  CheckSame( YamlTest::MakeDocument( 200, true, true ) );
+
+  // The index of one text isn't used for the next
+  std::string first = "long: " + std::string( 100, 'x' ) + ", y\n";
+  std::string_view second = "a: 1\nb: 2\n";
+  YamlTest::TranscriptHandler handler;
+  BasicYamlParser<YamlTest::TranscriptHandler> parser( first, handler );
+  parser.UseStructuralIndex( true );
+  YAML_CHECK( parser.Parse() );
+  YamlTest::TranscriptHandler secondHandler;
+  parser.Reset( second, secondHandler );
+  YAML_CHECK( parser.Parse() );
+  YAML_CHECK( secondHandler.GetTranscript() == YamlTest::GetTranscript( second ) );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestFindNext();
+  TestEvents();
+  return YamlTest::GetExitCode();
+}
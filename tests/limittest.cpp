@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  limittest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the limits on nesting depth and on the events and bytes aliases
+//  replay, which bound the resources a hostile document can use.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Nesting limited by the maximum depth, counting block and flow collections
+// but not the document itself
+bool ParseNested( std::string_view yaml, size_t maxDepth, bool& isMaxDepth )
+{
+  YamlTest::TranscriptHandler handler;
+  BasicYamlParser<YamlTest::TranscriptHandler> parser( yaml, handler );
+  parser.SetMaxDepth( maxDepth );
+  bool isParsed = parser.Parse();
+  isMaxDepth = handler.hasError && handler.errorCode == YamlErrorCode::MaxDepth;
+  return isParsed;
+}
+
+std::string MakeBlockNesting( size_t depth )
+{
+  std::string yaml;
+  for( size_t level = 0; level <= depth; ++level )
+    yaml += std::string( level * 2, ' ' ) + "k" + std::to_string( level ) + ":\n";
+  return yaml;
+}
+
+void TestMaxDepth()
+{
+  bool isMaxDepth = false;
+  for( size_t maxDepth : { 3u, 100u } )
+  {
+    auto flow = std::string( maxDepth, '[' ) + std::string( maxDepth, ']' );
+    YAML_CHECK( ParseNested( flow, maxDepth, isMaxDepth ) && !isMaxDepth );
+    YAML_CHECK( !ParseNested( "[" + flow + "]", maxDepth, isMaxDepth ) && isMaxDepth );
+    YAML_CHECK( ParseNested( MakeBlockNesting( maxDepth ), maxDepth, isMaxDepth ) && !isMaxDepth );
+    YAML_CHECK( !ParseNested( MakeBlockNesting( maxDepth + 1 ), maxDepth, isMaxDepth ) && isMaxDepth );
+  }
+  YAML_CHECK( ParseNested( "a:\n  b: [ x ]\n", 2, isMaxDepth ) && !isMaxDepth );
+  YAML_CHECK( !ParseNested( "a:\n  b: [ [ x ] ]\n", 2, isMaxDepth ) && isMaxDepth );
+
+  // The default allows deep documents, beyond the inline indentation stack
+  constexpr auto kDefaultMaxDepth = BasicYamlParser<YamlTest::TranscriptHandler>::kDefaultMaxDepth;
+  YAML_CHECK( ParseNested( MakeBlockNesting( kDefaultMaxDepth ), kDefaultMaxDepth, isMaxDepth ) && !isMaxDepth );
+  YAML_CHECK( !ParseNested( std::string( kDefaultMaxDepth + 1, '[' ), kDefaultMaxDepth, isMaxDepth ) && isMaxDepth );
+}
+
+// Aliases limited by the events and the bytes they replay
+void TestAliasExpansion()
+{
+  std::string yaml = "a: &a [ x, x, x, x, x, x, x, x, x, x ]\n";
+  const char* names = "abcdefgh";
+  for( int level = 1; level < 8; ++level )
+  {
+    yaml += std::string( 1, names[ level ] ) + ": &" + names[ level ] + " [";
+    for( int i = 0; i < 10; ++i )
+      yaml += std::string( i == 0 ? " *" : ", *" ) + names[ level - 1 ];
+    yaml += " ]\n";
+  }
+  YamlTest::TranscriptHandler handler;
+  BasicYamlParser<YamlTest::TranscriptHandler> parser( yaml, handler );
+  YAML_CHECK( !parser.Parse() );
+  YAML_CHECK( handler.errorCode == YamlErrorCode::AliasExpansion );
+
+  // Few events, many bytes
+  yaml = "a: &a " + std::string( 1 << 16, 'x' ) + "\nb: [ *a, *a, *a, *a ]\n";
+  YamlTest::TranscriptHandler bytesHandler;
+  BasicYamlParser<YamlTest::TranscriptHandler> bytesParser( yaml, bytesHandler );
+  bytesParser.SetMaxAliasBytes( 3u << 16 );
+  YAML_CHECK( !bytesParser.Parse() );
+  YAML_CHECK( bytesHandler.errorCode == YamlErrorCode::AliasExpansion );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestMaxDepth();
+  TestAliasExpansion();
+  return YamlTest::GetExitCode();
+}
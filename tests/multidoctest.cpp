@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  multidoctest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that multi-document streams are split at their document markers,
+//  and that ParseParallel reports each document to its own handler as Parse
+//  reports it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+bool IsDocument( const Yaml::Detail::DocumentText& doc, std::string_view text, size_t line )
+{
+  return doc.text == text && doc.line == line;
+}
+
+// Text without content stays with a neighboring document
+void TestSplitDocuments()
+{
+  auto docs = Yaml::Detail::SplitDocuments( "# header\n---\na: 1\n---\nb: 2\n...\n# between\n---\n- x\n# trailer\n" );
+  YAML_CHECK( docs.size() == 3u );
+  YAML_CHECK( IsDocument( docs[ 0 ], "# header\n---\na: 1\n", 1 ) );
+  YAML_CHECK( IsDocument( docs[ 1 ], "---\nb: 2\n...\n", 4 ) );
+  YAML_CHECK( IsDocument( docs[ 2 ], "# between\n---\n- x\n# trailer\n", 7 ) );
+
+  docs = Yaml::Detail::SplitDocuments( "a: 1" );
+  YAML_CHECK( docs.size() == 1u && IsDocument( docs[ 0 ], "a: 1", 1 ) );
+  docs = Yaml::Detail::SplitDocuments( "---\n...\n---\n" );
+  YAML_CHECK( docs.size() == 1u && IsDocument( docs[ 0 ], "---\n...\n---\n", 1 ) );
+
+  // Markers only count at the start of a line
+  docs = Yaml::Detail::SplitDocuments( "a: x --- y\nb: |\n  ---\n---\nc: 1\n" );
+  YAML_CHECK( docs.size() == 2u );
+  YAML_CHECK( IsDocument( docs[ 0 ], "a: x --- y\nb: |\n  ---\n", 1 ) );
+}
+
+std::vector<std::string> ParseParallel( std::string_view yaml, size_t docCount, size_t threadCount, bool& isParsed )
+{
+  std::vector<YamlTest::TranscriptHandler> handlers( docCount );
+  isParsed = BasicYamlParser<YamlTest::TranscriptHandler>::ParseParallel( yaml,
+    [&]( size_t i ) -> YamlTest::TranscriptHandler& { return handlers[ i ]; }, threadCount );
+  std::vector<std::string> transcripts;
+  for( const auto& handler : handlers )
+    transcripts.push_back( handler.GetTranscript() );
+  return transcripts;
+}
+
+void TestParseParallel()
+{
+  constexpr size_t kDocCount = 50u;
+  std::string yaml;
+  std::string expected;
+  for( size_t i = 0; i < kDocCount; ++i )
+  {
+    auto n = std::to_string( i );
+    yaml += "---\nid: " + n + "\nlist: [ a, 'b' ]\n";
+    expected += "SD K<id> S<" + n + "> K<list> SS S<a> S<b> ES ED ";
+  }
+  YAML_CHECK( YamlTest::GetTranscript( yaml ) == expected );
+  for( size_t threadCount : { 1u, 2u, 4u, 0u } )
+  {
+    bool isParsed = false;
+    std::string transcript;
+    for( const auto& docTranscript : ParseParallel( yaml, kDocCount, threadCount, isParsed ) )
+      transcript += docTranscript;
+    YAML_CHECK( isParsed );
+    YAML_CHECK( transcript == expected );
+  }
+
+  // An error fails only its own document
+  yaml = "a: 1\n---\nb:\n\tc: 2\n---\nd: 3\n";
+  bool isParsed = true;
+  auto transcripts = ParseParallel( yaml, 3, 2, isParsed );
+  YAML_CHECK( !isParsed );
+  YAML_CHECK( transcripts[ 0 ] == "SD K<a> S<1> ED " );
+  YAML_CHECK( transcripts[ 1 ].starts_with( "SD K<b> E<" ) );
+  YAML_CHECK( transcripts[ 2 ] == "SD K<d> S<3> ED " );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestSplitDocuments();
+  TestParseParallel();
+  return YamlTest::GetExitCode();
+}
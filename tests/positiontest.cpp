@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  positiontest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that the line and column the parser derives from its offsets match
+//  those found by counting lines in the text, for events and for errors.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Offsets of the start of each line
+class LineTable
+{
+public:
+
+  explicit LineTable( std::string_view text )
+  {
+    lineStarts_.push_back( 0u );
+    for( size_t i = 0; i < text.size(); ++i )
+    {
+      if( text[ i ] == '\n' )
+        lineStarts_.push_back( i + 1 );
+    }
+  }
+
+  size_t GetLine( size_t offset ) const
+  {
+    return static_cast<size_t>( std::upper_bound( lineStarts_.begin(), lineStarts_.end(), offset ) -
+                                lineStarts_.begin() );
+  }
+
+  size_t GetCol( size_t offset ) const
+  {
+    return offset - lineStarts_[ GetLine( offset ) - 1 ] + 1;
+  }
+
+private:
+
+  std::vector<size_t> lineStarts_;
+};
+
+// Compares the parser's position at every event with the line table
+class PositionHandler : public YamlStaticHandler
+{
+public:
+
+  PositionHandler( std::string_view text, const LineTable& lines ) :
+    text_( text ),
+    lines_( lines )
+  {
+  }
+
+  // The parser's type can't be named until the handler is complete
+  template <typename Parser>
+  void SetParser( const Parser& parser )
+  {
+    getPosition_ = [&parser]( size_t& line, size_t& col, size_t& offset )
+    {
+      line = parser.GetLine();
+      col = parser.GetCol();
+      offset = parser.GetOffset();
+    };
+  }
+
+  void onStartSequence() { CheckPosition(); }
+  void onEndSequence() { CheckPosition(); }
+  void onStartMapping() { CheckPosition(); }
+  void onEndMapping() { CheckPosition(); }
+  bool onKey( std::string_view ) { CheckPosition(); return true; }
+  bool onScalar( std::string_view ) { CheckPosition(); return true; }
+
+  void onErrorCode( const YamlError& error )
+  {
+    ++errors;
+    errorOffset = error.offset;
+    YAML_CHECK( error.offset <= text_.size() );
+    YAML_CHECK( error.line == lines_.GetLine( error.offset ) );
+    YAML_CHECK( error.col == lines_.GetCol( error.offset ) );
+  }
+
+  size_t events = 0u;
+  size_t errors = 0u;
+  size_t errorOffset = 0u;
+
+private:
+
+  void CheckPosition()
+  {
+    ++events;
+    size_t line = 0u, col = 0u, offset = 0u;
+    getPosition_( line, col, offset );
+    if( !YAML_CHECK( offset <= text_.size() ) )
+      return;
+    YAML_CHECK( line == lines_.GetLine( offset ) );
+    YAML_CHECK( col == lines_.GetCol( offset ) );
+  }
+
+private:
+
+  std::string_view text_;
+  const LineTable& lines_;
+  std::function<void( size_t& line, size_t& col, size_t& offset )> getPosition_;
+};
+
+// Returns the number of errors reported, and the offset of the last
+size_t CheckText( std::string_view text, bool isChunked, size_t* errorOffset = nullptr )
+{
+  LineTable lines( text );
+  PositionHandler handler( text, lines );
+  BasicYamlParser<PositionHandler> parser( text, handler );
+  handler.SetParser( parser );
+  if( isChunked )
+    parser.ParseChunked( 4 );
+  else
+    parser.Parse();
+  YAML_CHECK( handler.events != 0u || handler.errors != 0u );
+  if( errorOffset != nullptr )
+    *errorOffset = handler.errorOffset;
+  return handler.errors;
+}
+
+void TestEvents()
+{
+  for( bool isSequence : { false, true } )
+  {
+    for( bool isCrlf : { false, true } )
+    {
+      auto yaml = YamlTest::MakeDocument( 2000, isSequence, isCrlf );
+      YAML_CHECK( CheckText( yaml, false ) == 0u );
+      YAML_CHECK( CheckText( yaml, true ) == 0u );
+    }
+  }
+}
+
+void TestErrors()
+{
+  constexpr std::string_view kErrors[] =
+  {
+    "a:\n\tb: 1\n",
+    "a: \"unterminated\n  text\n",
+    "a: *unknown\n",
+    "a: 1\nb: !e!x 2\n",
+    "a: 1\r\nb: 'x\r\n",
+    "a: \"\\q\"\n",
+    "a: |x\n  b\n"
+  };
+  for( auto yaml : kErrors )
+    YAML_CHECK( CheckText( yaml, false ) == 1u );
+
+  // Errors in anchors, aliases and tags are reported at their indicators
+  constexpr std::pair<std::string_view, size_t> kIndicatorErrors[] =
+  {
+    { "a: *nope\n", 3u },
+    { "a: &x 1\nb: [ *x, *nope ]\n", 17u },
+    { "a: &x 1\n*x : 2\n", 8u },
+    { "a: 1\nb: !e!x 2\n", 8u },
+    { "a: & 1\n", 3u }
+  };
+  for( auto [ yaml, expected ] : kIndicatorErrors )
+  {
+    size_t errorOffset = 0u;
+    YAML_CHECK( CheckText( yaml, false, &errorOffset ) == 1u );
+    YAML_CHECK( errorOffset == expected );
+  }
+
+  // An error late in a large document is found by the fallback to Parse()
+  auto yaml = YamlTest::MakeDocument( 2000, false ) + "bad:\n\ttab: 1\n";
+  YAML_CHECK( CheckText( yaml, true ) == 1u );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestEvents();
+  TestErrors();
+  return YamlTest::GetExitCode();
+}
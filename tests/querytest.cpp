@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  querytest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the values YamlQuery finds for its paths.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Keys of block sequence entries addressed by index
+void TestQuery()
+{
+  YamlQuery query;
+  YAML_CHECK( query.AddPath( "s[1].n" ) );
+  YAML_CHECK( query.AddPath( "s[0].m[1]" ) );
+  YAML_CHECK( query.AddPath( "s[2]" ) );
+  YAML_CHECK( query.Run( "s:\n  - n: 1\n    m: [ a, b ]\n  - n: 2\n  - 3\nt: 4\n" ) );
+  YAML_CHECK( query.GetValue( 0 ) == "2" );
+  YAML_CHECK( query.GetValue( 1 ) == "b" );
+  YAML_CHECK( query.GetValue( 2 ) == "3" );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestQuery();
+  return YamlTest::GetExitCode();
+}
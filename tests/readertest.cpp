@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  readertest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the events YamlReader returns, with their values, styles and
+//  positions, and skipping values on request.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Reads all events, writing each as its type letter followed by any text
+std::string ReadAll( std::string_view yaml, std::string_view skipKey = {} )
+{
+  YamlReader reader( yaml );
+  YamlEvent event;
+  std::string transcript;
+  while( reader.Next( event ) )
+  {
+    switch( event.type )
+    {
+    case YamlEvent::Type::StartDocument: transcript += "SD "; break;
+    case YamlEvent::Type::EndDocument:   transcript += "ED "; break;
+    case YamlEvent::Type::StartSequence: transcript += "SS "; break;
+    case YamlEvent::Type::EndSequence:   transcript += "ES "; break;
+    case YamlEvent::Type::StartMapping:  transcript += "SM "; break;
+    case YamlEvent::Type::EndMapping:    transcript += "EM "; break;
+    case YamlEvent::Type::Key:           transcript.append( "K<" ).append( event.str ).append( "> " ); break;
+    case YamlEvent::Type::Scalar:        transcript.append( "S<" ).append( event.str ).append( "> " ); break;
+    case YamlEvent::Type::Error:         transcript += "E "; break;
+    }
+    if( event.type == YamlEvent::Type::Key && event.str == skipKey )
+      YAML_CHECK( reader.Skip() );
+  }
+  return transcript;
+}
+
+void TestEvents()
+{
+  YAML_CHECK( ReadAll( "a: 1\nb:\n  - x\n  - { c: 'y' }\n---\nd: \"z\\n\"\n" ) ==
+              "SD K<a> S<1> K<b> SS S<x> SM K<c> S<y> EM ES ED SD K<d> S<z\n> ED " );
+  YAML_CHECK( ReadAll( "" ) == "SD ED " );
+
+  // An error is the last event
+  YAML_CHECK( ReadAll( "a: 1\nb:\n\tc: 2\nd: 3\n" ) == "SD K<a> S<1> K<b> E " );
+}
+
+void TestValues()
+{
+  YamlReader reader( "a: plain\nb: 'single'\nc: |\n  block\n" );
+  YamlEvent event;
+  YAML_CHECK( reader.Next( event ) && event.type == YamlEvent::Type::StartDocument );
+  YAML_CHECK( reader.Next( event ) && event.type == YamlEvent::Type::Key && event.str == "a" );
+  YAML_CHECK( event.line == 1u && event.col == 1u && event.offset == 0u );
+  YAML_CHECK( reader.Next( event ) && event.str == "plain" && event.style == YamlScalarStyle::Plain );
+  YAML_CHECK( reader.Next( event ) && event.str == "b" && event.line == 2u && event.offset == 9u );
+  YAML_CHECK( reader.Next( event ) && event.str == "single" && event.style == YamlScalarStyle::SingleQuoted );
+  YAML_CHECK( event.line == 2u && event.col == 11u ); // at the closing quote
+  YAML_CHECK( reader.Next( event ) && event.str == "c" && event.line == 3u );
+  YAML_CHECK( reader.Next( event ) && event.str == "block\n" && event.style == YamlScalarStyle::Literal );
+  YAML_CHECK( reader.Next( event ) && event.type == YamlEvent::Type::EndDocument );
+  YAML_CHECK( !reader.Next( event ) );
+  YAML_CHECK( !reader.Next( event ) );
+}
+
+void TestSkip()
+{
+  constexpr std::string_view kYaml = "a: 1\nb:\n  c: [ 1, { d: 2 } ]\n  e:\n    - 3\nf: { g: 4 }\nh: 5\n";
+  YAML_CHECK( ReadAll( kYaml, "b" ) == "SD K<a> S<1> K<b> K<f> SM K<g> S<4> EM K<h> S<5> ED " );
+  YAML_CHECK( ReadAll( kYaml, "f" ) == "SD K<a> S<1> K<b> SM K<c> SS S<1> SM K<d> S<2> EM ES K<e> SS S<3> ES EM K<f> K<h> S<5> ED " );
+  YAML_CHECK( ReadAll( kYaml, "h" ) == "SD K<a> S<1> K<b> SM K<c> SS S<1> SM K<d> S<2> EM ES K<e> SS S<3> ES EM K<f> SM K<g> S<4> EM K<h> ED " );
+
+  // Only a key's value can be skipped
+  YamlReader reader( kYaml );
+  YamlEvent event;
+  YAML_CHECK( !reader.Skip() );
+  YAML_CHECK( reader.Next( event ) && !reader.Skip() );
+  YAML_CHECK( reader.Next( event ) && reader.Skip() );
+  YAML_CHECK( !reader.Skip() );
+  YAML_CHECK( reader.Next( event ) && event.type == YamlEvent::Type::Key && event.str == "b" );
+}
+
+// Skipping the value of a key replayed from an anchor
+void TestSkipReplayed()
+{
+  constexpr std::string_view kDocuments[] =
+  {
+    "a: &x {b: 1, c: 2}\nd: *x\ne: 5\n",
+    "a: &x\n  b: [1, 2]\n  c: 2\nd: *x\ne: 5\n",
+    "a: &x {b: {q: 1}, c: 2}\nd: *x\ne: 5\n"
+  };
+  for( auto yaml : kDocuments )
+  {
+    YamlReader reader( yaml );
+    YamlEvent event;
+    std::string transcript;
+    while( reader.Next( event ) )
+    {
+      if( event.type == YamlEvent::Type::Key || event.type == YamlEvent::Type::Scalar )
+        transcript.append( event.str ).append( " " );
+      if( event.type == YamlEvent::Type::Key && event.str == "b" )
+        YAML_CHECK( reader.Skip() );
+    }
+    YAML_CHECK( transcript == "a b c 2 d b c 2 e 5 " );
+  }
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestEvents();
+  TestValues();
+  TestSkip();
+  TestSkipReplayed();
+  return YamlTest::GetExitCode();
+}
@@ -0,0 +1,370 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  scalartest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the values of scalars: the characters that require quoting them on
+//  output, their core schema types, the text the parser reports for them, and
+//  the values a YamlTagRegistry decodes for tagged scalars.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+constexpr size_t kNone = std::string_view::npos;
+
+bool IsSpecial( std::string_view scalar, size_t specialPos, size_t singleQuote, size_t doubleQuote )
+{
+  auto special = Yaml::GetSpecialChars( scalar );
+  return special.hasSpecialChars && special.firstSpecialPos == specialPos &&
+         special.specialChar == scalar[ specialPos ] &&
+         special.firstSingleQuote == singleQuote && special.firstDoubleQuote == doubleQuote;
+}
+
+// Special characters and quotes are found at any position, including the
+// first, and within or after 16-byte blocks
+void TestSpecialChars()
+{
+  YAML_CHECK( !Yaml::GetSpecialChars( "" ).hasSpecialChars );
+  YAML_CHECK( !Yaml::GetSpecialChars( "plain text 123 ABC xyz" ).hasSpecialChars );
+  YAML_CHECK( !Yaml::GetSpecialChars( "'already quoted: yes'" ).hasSpecialChars );
+
+  YAML_CHECK( IsSpecial( "-1", 0, kNone, kNone ) );
+  YAML_CHECK( IsSpecial( "'tis here: now", 0, 0, kNone ) );
+  YAML_CHECK( IsSpecial( "\"a\" and 'b'", 0, 8, 0 ) );
+  YAML_CHECK( IsSpecial( "a: b", 1, kNone, kNone ) );
+  YAML_CHECK( IsSpecial( "it's", 2, 2, kNone ) );
+  YAML_CHECK( IsSpecial( "abcdefghijklmnopqrstu: x", 21, kNone, kNone ) );
+  YAML_CHECK( IsSpecial( "abcdefghijklmno\"pq\"", 15, kNone, 15 ) );
+  YAML_CHECK( IsSpecial( "0123456789ABCDEFGHIJKLMNOPQRSTUV\tx", 32, kNone, kNone ) );
+  YAML_CHECK( IsSpecial( "caf\xE9 creme", 3, kNone, kNone ) );
+  YAML_CHECK( IsSpecial( "{", 0, kNone, kNone ) );
+}
+
+bool IsType( std::string_view scalar, Yaml::ScalarType type )
+{
+  return Yaml::DecodeScalar( scalar ).type == type;
+}
+
+bool IsInt( std::string_view scalar, int64_t value )
+{
+  auto typed = Yaml::DecodeScalar( scalar );
+  return typed.type == Yaml::ScalarType::Int && typed.intValue == value;
+}
+
+bool IsFloat( std::string_view scalar, double value )
+{
+  auto typed = Yaml::DecodeScalar( scalar );
+  return typed.type == Yaml::ScalarType::Float && typed.floatValue == value;
+}
+
+// Plain scalars resolved with the YAML 1.2 core schema
+void TestDecodeScalar()
+{
+  for( auto null : { "", "~", "null", "Null", "NULL" } )
+    YAML_CHECK( IsType( null, Yaml::ScalarType::Null ) );
+  for( auto str : { "nULL", "yes", "no", "on", "tRUE", "1.2.3", "0x", "0o", "-", "+", ".", "1_000", "12abc", "inf", "nan" } )
+    YAML_CHECK( IsType( str, Yaml::ScalarType::String ) );
+
+  for( auto isTrue : { "true", "True", "TRUE" } )
+    YAML_CHECK( Yaml::DecodeScalar( isTrue ).type == Yaml::ScalarType::Bool && Yaml::DecodeScalar( isTrue ).boolValue );
+  for( auto isFalse : { "false", "False", "FALSE" } )
+    YAML_CHECK( Yaml::DecodeScalar( isFalse ).type == Yaml::ScalarType::Bool && !Yaml::DecodeScalar( isFalse ).boolValue );
+
+  YAML_CHECK( IsInt( "0", 0 ) );
+  YAML_CHECK( IsInt( "42", 42 ) );
+  YAML_CHECK( IsInt( "-17", -17 ) );
+  YAML_CHECK( IsInt( "+17", 17 ) );
+  YAML_CHECK( IsInt( "0x1F", 31 ) );
+  YAML_CHECK( IsInt( "0o17", 15 ) );
+  YAML_CHECK( IsInt( "-9223372036854775808", INT64_MIN ) );
+
+  YAML_CHECK( IsFloat( "1.5", 1.5 ) );
+  YAML_CHECK( IsFloat( "-.5", -0.5 ) );
+  YAML_CHECK( IsFloat( "+12e3", 12000.0 ) );
+  YAML_CHECK( IsFloat( "1E-2", 0.01 ) );
+  YAML_CHECK( IsFloat( ".inf", std::numeric_limits<double>::infinity() ) );
+  YAML_CHECK( IsFloat( "+.Inf", std::numeric_limits<double>::infinity() ) );
+  YAML_CHECK( IsFloat( "-.INF", -std::numeric_limits<double>::infinity() ) );
+  for( auto nan : { ".nan", ".NaN", ".NAN" } )
+  {
+    auto typed = Yaml::DecodeScalar( nan );
+    YAML_CHECK( typed.type == Yaml::ScalarType::Float && std::isnan( typed.floatValue ) );
+  }
+}
+
+std::string Decode( std::string_view text, char quote = '\"' )
+{
+  std::string str;
+  size_t errPos = 0u;
+  YAML_CHECK( Yaml::Detail::DecodeQuoted( text, quote, str, errPos ) );
+  return str;
+}
+
+bool IsInvalidEscape( std::string_view text, size_t errPos )
+{
+  std::string str;
+  size_t pos = 0u;
+  return !Yaml::Detail::DecodeQuoted( text, '\"', str, pos ) && pos == errPos;
+}
+
+// Writes each scalar, noting those that are views of the source text
+struct SourceHandler : YamlStaticHandler
+{
+  explicit SourceHandler( std::string_view text ) : source( text ) {}
+
+  bool onKey( std::string_view ) { return true; }
+  bool onScalar( std::string_view scalar )
+  {
+    transcript.append( "S<" ).append( scalar ).append( ">" );
+    if( scalar.data() >= source.data() && scalar.data() + scalar.size() <= source.data() + source.size() )
+      transcript += "@source";
+    transcript += " ";
+    return true;
+  }
+
+  std::string_view source;
+  std::string transcript;
+};
+
+// Escape sequences of double-quoted scalars and '' in single-quoted ones
+void TestEscapes()
+{
+  YAML_CHECK( Decode( "no escapes" ) == "no escapes" );
+  YAML_CHECK( Decode( "a\\0b" ) == std::string( "a\0b", 3 ) );
+  YAML_CHECK( Decode( "\\a\\b\\t\\\t\\n\\v\\f\\r\\e" ) == "\a\b\t\t\n\v\f\r\x1B" );
+  YAML_CHECK( Decode( "\\ \\\"\\/\\\\" ) == " \"/\\" );
+  YAML_CHECK( Decode( "\\N\\_\\L\\P" ) == "\xC2\x85\xC2\xA0\xE2\x80\xA8\xE2\x80\xA9" );
+  YAML_CHECK( Decode( "\\x41\\u00e9\\U0001F600" ) == "A\xC3\xA9\xF0\x9F\x98\x80" );
+  YAML_CHECK( Decode( "\\uD83D\\uDE00" ) == "\xF0\x9F\x98\x80" ); // surrogate pair
+  YAML_CHECK( Decode( "a\\\n   b\\\r\n\tc" ) == "abc" );         // escaped line breaks
+  YAML_CHECK( Decode( "it''s ''x''", '\'' ) == "it's 'x'" );
+
+  // Line breaks fold to a space, or to a line end per empty line
+  YAML_CHECK( Decode( "first \n  second" ) == "first second" );
+  YAML_CHECK( Decode( "a\r\n\t\r\n  \n  b\n  " ) == "a\n\nb " );
+  YAML_CHECK( Decode( "first\n  second\\\n  third" ) == "first secondthird" );
+  YAML_CHECK( Decode( "x\\t \n y" ) == "x\t y" ); // escaped blanks are kept
+  YAML_CHECK( Decode( "x\n\n  y", '\'' ) == "x\ny" );
+
+  YAML_CHECK( IsInvalidEscape( "ok \\q", 3 ) );
+  YAML_CHECK( IsInvalidEscape( "\\x4", 0 ) );
+  YAML_CHECK( IsInvalidEscape( "a\\tb\\u12G4", 4 ) );
+  YAML_CHECK( IsInvalidEscape( "\\U00110000", 0 ) ); // beyond Unicode
+  YAML_CHECK( IsInvalidEscape( "end\\", 3 ) );
+
+  // Through the parser; text without escapes is passed on in place
+  std::string_view yaml = "a: \"x\\ty\\u0021\"\nb: \"in place\"\nc: 'it''s'\nd: 'as is'\n";
+  SourceHandler handler( yaml );
+  BasicYamlParser<SourceHandler> parser( yaml, handler );
+  YAML_CHECK( parser.Parse() );
+  YAML_CHECK( handler.transcript == "S<x\ty!> S<in place>@source S<it's> S<as is>@source " );
+
+  // Multi-line scalars are folded whether or not they have escapes
+  std::string_view multiLine = "a: \"first\n  second\"\nb: 'x\n  y'\nc: \"x\\\n  y\n  z\"\n";
+  SourceHandler multiLineHandler( multiLine );
+  BasicYamlParser<SourceHandler> multiLineParser( multiLine, multiLineHandler );
+  YAML_CHECK( multiLineParser.Parse() );
+  YAML_CHECK( multiLineHandler.transcript == "S<first second> S<x y> S<xy z> " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: \"bad \\q\"\n" ).starts_with( "SD K<a> E<" ) );
+}
+
+// Writes each scalar as its type letter followed by its value
+struct TypedTranscript : YamlTypedHandler<TypedTranscript>
+{
+  bool onNull() { transcript += "N "; return true; }
+  bool onBool( bool value ) { transcript += value ? "B<true> " : "B<false> "; return true; }
+  bool onInt( int64_t value ) { transcript += "I<" + std::to_string( value ) + "> "; return true; }
+  bool onDouble( double value ) { transcript += "D<" + std::to_string( value ) + "> "; return true; }
+  bool onString( std::string_view value ) { transcript.append( "S<" ).append( value ).append( "> " ); return true; }
+  bool onKey( std::string_view ) { return true; }
+
+  std::string transcript;
+};
+
+// Only plain scalars are typed; quoted and block scalars are strings
+void TestTypedHandler()
+{
+  TypedTranscript handler;
+  BasicYamlParser<TypedTranscript> parser( "a: ~\nb: [ true, 0x10, 2.5, text, '1', \"null\" ]\nc:\nd: |\n  3\n", handler );
+  YAML_CHECK( parser.Parse() );
+  YAML_CHECK( handler.transcript == "N B<true> I<16> D<2.500000> S<text> S<1> S<null> N S<3\n> " );
+}
+
+// Literal and folded block scalars with each chomping indicator
+void TestBlockScalars()
+{
+  YAML_CHECK( YamlTest::GetTranscript( "a: |\n  one\n  two\n\n\nb: 1\n" ) == "SD K<a> S<one\ntwo\n> K<b> S<1> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: |-\n  one\n  two\n\n\nb: 1\n" ) == "SD K<a> S<one\ntwo> K<b> S<1> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: |+\n  one\n  two\n\n\nb: 1\n" ) == "SD K<a> S<one\ntwo\n\n\n> K<b> S<1> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: >\n  one\n  two\n\n  three\n   more\n  four\n\nb: 1\n" ) ==
+              "SD K<a> S<one two\nthree\n more\nfour\n> K<b> S<1> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: >-\n  one\n  two\n" ) == "SD K<a> S<one two> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: >+\n  one\n\n" ) == "SD K<a> S<one\n\n> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "- >\n\n  lead\n  x\n- |1-\n  y\n" ) == "SD SS - S<\nlead x\n> - S< y> ES ED " );
+
+  // Explicit indentation, header comments, CRLF and missing line ends
+  YAML_CHECK( YamlTest::GetTranscript( "a: |2\n    indented\n  base\n" ) == "SD K<a> S<  indented\nbase\n> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: | # comment\n  text\n" ) == "SD K<a> S<text\n> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: |\r\n  one\r\n  two\r\n" ) == "SD K<a> S<one\ntwo\n> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: |\n  last" ) == "SD K<a> S<last> ED " );
+  YAML_CHECK( YamlTest::GetTranscript( "a: |\nb: 1\n" ) == "SD K<a> S<> K<b> S<1> ED " );
+}
+
+// Numbers beyond the range of their type
+void TestDecodeRange()
+{
+  auto typed = Yaml::DecodeScalar( "0x8000000000000000" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Float && typed.floatValue == 9223372036854775808.0 );
+  typed = Yaml::DecodeScalar( "0o1777777777777777777777" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Float && typed.floatValue == 18446744073709551615.0 );
+  typed = Yaml::DecodeScalar( "9223372036854775808" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Float );
+  typed = Yaml::DecodeScalar( "1e400" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Float && std::isinf( typed.floatValue ) && typed.floatValue > 0 );
+  typed = Yaml::DecodeScalar( "-1e400" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Float && std::isinf( typed.floatValue ) && typed.floatValue < 0 );
+  typed = Yaml::DecodeScalar( "1e-400" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Float && typed.floatValue == 0.0 );
+  typed = Yaml::DecodeScalar( "0x7FFFFFFFFFFFFFFF" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::Int && typed.intValue == INT64_MAX );
+  typed = Yaml::DecodeScalar( "0xG" );
+  YAML_CHECK( typed.type == Yaml::ScalarType::String );
+}
+
+// Decoded tag values delivered alongside the text as written
+struct TaggedHandler : public YamlStaticHandler
+{
+  std::string bytes;
+  std::string scalar;
+  Yaml::TaggedValue timestamp;
+  size_t taggedCount = 0u;
+  bool hasError = false;
+
+  void onTagged( std::string_view tag, const Yaml::TaggedValue& value )
+  {
+    ++taggedCount;
+    if( tag.ends_with( "timestamp" ) )
+      timestamp = value;
+    else
+      bytes = value.bytes;
+  }
+  bool onScalar( std::string_view str )
+  {
+    scalar = str;
+    return true;
+  }
+  void onErrorCode( const YamlError& )
+  {
+    hasError = true;
+  }
+};
+
+// Tags and decoded values through the virtual interface
+struct VirtualTaggedHandler : public YamlHandler
+{
+  std::string tags;
+  std::string bytes;
+
+  void onTag( std::string_view tag ) override
+  {
+    tags.append( tag ).append( 1, ' ' );
+  }
+  void onTagged( std::string_view, const Yaml::TaggedValue& value ) override
+  {
+    bytes += value.bytes;
+  }
+};
+
+void TestTags()
+{
+  YamlTagRegistry registry;
+  size_t customCount = 0u;
+  registry.Add( "!count", [&customCount]( std::string_view text, Yaml::TaggedValue& value )
+  {
+    ++customCount;
+    value.bytes = text;
+    return true;
+  } );
+
+  TaggedHandler handler;
+  std::string_view yaml = "a: !!binary SGk=\nb: !count c\nt: !!timestamp 2001-12-14 21:59:43.10 -5\n";
+  BasicYamlParser<TaggedHandler> parser( yaml, handler );
+  parser.SetTagRegistry( &registry );
+  YAML_CHECK( parser.Parse() );
+  YAML_CHECK( customCount == 1u );
+  YAML_CHECK( handler.bytes == "c" );
+  YAML_CHECK( handler.scalar == "2001-12-14 21:59:43.10 -5" );
+  using namespace std::chrono;
+  auto expected = sys_days( 2001y / December / 15 ) + hours( 2 ) + minutes( 59 ) + seconds( 43 ) + milliseconds( 100 );
+  YAML_CHECK( handler.timestamp.time == expected );
+  YAML_CHECK( !handler.timestamp.isDate );
+
+  TaggedHandler invalidHandler;
+  BasicYamlParser<TaggedHandler> invalidParser( "a: !!binary S=Gk\n", invalidHandler );
+  invalidParser.SetTagRegistry( &registry );
+  YAML_CHECK( !invalidParser.Parse() );
+
+  // Tagged nodes with no value aren't decoded
+  constexpr std::string_view kEmpty[] =
+  {
+    "a: !!timestamp\nb: 1\n",
+    "a: !!binary\n",
+    "a: { b: !!binary }\n",
+    "- x: !count\n  y: 2\n"
+  };
+  for( auto empty : kEmpty )
+  {
+    TaggedHandler emptyHandler;
+    BasicYamlParser<TaggedHandler> emptyParser( empty, emptyHandler );
+    emptyParser.SetTagRegistry( &registry );
+    YAML_CHECK( emptyParser.Parse() );
+    YAML_CHECK( emptyHandler.taggedCount == 0u && !emptyHandler.hasError );
+  }
+  YAML_CHECK( customCount == 1u );
+
+  VirtualTaggedHandler virtualHandler;
+  YamlParser virtualParser( yaml, virtualHandler );
+  virtualParser.SetTagRegistry( &registry );
+  YAML_CHECK( virtualParser.Parse() );
+  YAML_CHECK( virtualHandler.tags == "tag:yaml.org,2002:binary !count tag:yaml.org,2002:timestamp " );
+  YAML_CHECK( virtualHandler.bytes == "Hic" );
+  YAML_CHECK( customCount == 2u );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestSpecialChars();
+  TestDecodeScalar();
+  TestDecodeRange();
+  TestTypedHandler();
+  TestEscapes();
+  TestBlockScalars();
+  TestTags();
+  return YamlTest::GetExitCode();
+}
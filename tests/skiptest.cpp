@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  skiptest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that handlers returning YamlKeyAction::Skip from onKey receive no
+//  events for the skipped values, and that parsing resumes at the next key
+//  with the lines of the skipped text counted.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Skips the values of keys starting with "skip"
+struct SkipHandler : public YamlTest::TranscriptHandler
+{
+  YamlKeyAction onKey( std::string_view key )
+  {
+    TranscriptHandler::onKey( key );
+    return key.starts_with( "skip" ) ? YamlKeyAction::Skip : YamlKeyAction::Continue;
+  }
+};
+
+std::string GetSkipTranscript( std::string_view yaml, bool hasPositions = false )
+{
+  SkipHandler handler;
+  BasicYamlParser<SkipHandler> parser( yaml, handler );
+  if( hasPositions )
+    handler.SetParser( parser );
+  YAML_CHECK( parser.Parse() );
+  return handler.GetTranscript();
+}
+
+// The end of each kind of value, found without parsing it
+void TestSkipValue()
+{
+  auto checkEnd = []( std::string_view yaml, std::string_view rest, size_t expectedLines, bool isFlow = false )
+  {
+    size_t lines = 0u;
+    auto colon = yaml.find( ':' );
+    auto next = Yaml::Detail::SkipValue( yaml.data() + colon + 1, yaml.data() + yaml.size(), 0u, isFlow, lines );
+    return std::string_view( next, static_cast<size_t>( yaml.data() + yaml.size() - next ) ) == rest &&
+           lines == expectedLines;
+  };
+  YAML_CHECK( checkEnd( "a: 1\nb: 2\n", "\nb: 2\n", 0u ) );
+  YAML_CHECK( checkEnd( "a:\n  b:\n    c: 1\n\n  # note\n  d: 2\ne: 3\n", "\ne: 3\n", 5u ) );
+  YAML_CHECK( checkEnd( "a: [ \"]\", '}', { b: \"x\\\"]\" } ]\nc: 1\n", "\nc: 1\n", 0u ) );
+  YAML_CHECK( checkEnd( "a: |\n  b: 1\n  [ x\n\nc: 1\n", "\nc: 1\n", 3u ) );
+  YAML_CHECK( checkEnd( "a: 'x\n  y'\nc: 1\n", "\nc: 1\n", 1u ) );
+  YAML_CHECK( checkEnd( "a: [ 1, ']' ], b: 2 }", ", b: 2 }", 0u, true ) );
+  YAML_CHECK( checkEnd( "a: 1 }", "}", 0u, true ) );
+}
+
+// Skipped values report no events; the keys after them report their lines
+void TestSkipKeys()
+{
+  constexpr std::string_view kYaml =
+    "a: 1\n"
+    "skip1:\n"
+    "  nested:\n"
+    "    deep: [ 1, 2 ]\n"
+    "  other: x\n"
+    "b: 2\n"
+    "skip2: { s: \"] } ]\", t: [ '}', \"]\" ], u: 'it''s ]' }\n"
+    "c: 3\n"
+    "skip3: |\n"
+    "  block text\n"
+    "  d: not a key\n"
+    "\n"
+    "d: 4\n"
+    "skip4: >\n"
+    "  folded\n"
+    "e: 5\n";
+  YAML_CHECK( GetSkipTranscript( kYaml, true ) ==
+              "SD@1:1 K<a>@1:1 S<1>@1:4 K<skip1>@2:5 K<b>@6:1 S<2>@6:4 K<skip2>@7:5 K<c>@8:1 S<3>@8:4 "
+              "K<skip3>@9:5 K<d>@13:1 S<4>@13:4 K<skip4>@14:5 K<e>@16:1 S<5>@16:4 ED@17:1 " );
+
+  // Within a flow mapping and a block sequence entry
+  YAML_CHECK( GetSkipTranscript( "m: { skip: [ 1, '}' ], k: v }\nn: 1\n" ) ==
+              "SD K<m> SM K<skip> K<k> S<v> EM K<n> S<1> ED " );
+  YAML_CHECK( GetSkipTranscript( "- skip: { x: 1 }\n  k: w\n- z\n" ) == "SD SS - K<skip> K<k> S<w> - S<z> ES ED " );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestSkipValue();
+  TestSkipKeys();
+  return YamlTest::GetExitCode();
+}
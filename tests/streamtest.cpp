@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  streamtest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks that YamlStreamParser reports the events Parse reports, however the
+//  text is split into chunks, including tokens that span many chunks.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// YamlStreamParser calls handlers through the YamlHandler interface
+class VirtualTranscriptHandler : public YamlHandler
+{
+public:
+
+  void onStartDocument() override { transcript_.onStartDocument(); }
+  void onEndDocument() override { transcript_.onEndDocument(); }
+  void onStartSequence() override { transcript_.onStartSequence(); }
+  void onEndSequence() override { transcript_.onEndSequence(); }
+  void onStartMapping() override { transcript_.onStartMapping(); }
+  void onEndMapping() override { transcript_.onEndMapping(); }
+  bool onKey( std::string_view key ) override { return transcript_.onKey( key ); }
+  bool onScalar( std::string_view scalar ) override { return transcript_.onScalar( scalar ); }
+  void onErrorCode( const YamlError& error ) override { transcript_.onErrorCode( error ); }
+
+  const std::string& GetTranscript() const
+  {
+    return transcript_.GetTranscript();
+  }
+
+private:
+
+  YamlTest::TranscriptHandler transcript_;
+};
+
+std::string GetTranscript( std::string_view yaml )
+{
+  VirtualTranscriptHandler handler;
+  YamlParser parser( yaml, handler );
+  parser.Parse();
+  return handler.GetTranscript();
+}
+
+std::string GetStreamTranscript( std::string_view yaml, size_t chunkSize )
+{
+  VirtualTranscriptHandler handler;
+  YamlStreamParser parser( handler );
+  for( size_t pos = 0; pos < yaml.size(); pos += chunkSize )
+  {
+    if( !parser.Feed( yaml.substr( pos, chunkSize ) ) )
+      return handler.GetTranscript();
+  }
+  parser.Finish();
+  return handler.GetTranscript();
+}
+
+void CheckSame( std::string_view yaml )
+{
+  auto expected = GetTranscript( yaml );
+  for( size_t chunkSize : { 1u, 2u, 3u, 7u, 64u, 4096u } )
+    YAML_CHECK( GetStreamTranscript( yaml, chunkSize ) == expected );
+  YAML_CHECK( GetStreamTranscript( yaml, std::max( yaml.size(), size_t( 1 ) ) ) == expected );
+}
+
+void TestEvents()
+{
+  YAML_CHECK( GetStreamTranscript( "a: \"x\\ty\"\nb: [ 1, 'it''s' ]\nc:\n  - d\n", 3 ) ==
+              "SD K<a> S<x\ty> K<b> SS S<1> S<it's> ES K<c> SS S<d> ES ED " );
+  CheckSame( "" );
+  CheckSame( "a: 1" ); // no final line end
+  YAML_CHECK( GetStreamTranscript( "a: \"first\n  second\\\n  third\"\nb: 'x\n\n  y'\n", 2 ) ==
+              "SD K<a> S<first secondthird> K<b> S<x\ny> ED " );
+  CheckSame( "a: \"first\n  second\\\n  third\"\nb: 'x\n\n  y'\n" );
+  CheckSame( "a: \"\\\\\"\nb: \"\\\"\"\n" ); // escaped backslash and quote
+  CheckSame( "a: \"x\\\r\n  y\"\r\nb: 2\r\n" );
+  CheckSame( "a: |\n  one\n\n   two\n  \nb: >-\n  three\n  four\n\nc: |+\n  five\n\n" );
+  CheckSame( "- |\r\n  one\r\n   two\r\n- >\n\n  three\n" );
+  CheckSame( YamlTest::MakeDocument( 40, false ) );
+  CheckSame( YamlTest::MakeDocument( 40, true, true ) );
+}
+
+// A quoted scalar spanning many chunks is scanned once, not once per chunk
+void TestLargeQuoted()
+{
+  std::string text;
+  for( size_t i = 0; i < 100000; ++i )
+    text += "line of quoted text \\t with an escape\n  ";
+  for( char quote : { '"', '\'' } )
+  {
+    std::string yaml = "a: ";
+    yaml.append( 1, quote ).append( text ).append( 1, quote ).append( "\nb: 1\n" );
+    auto expected = GetTranscript( yaml );
+    YAML_CHECK( expected.starts_with( "SD K<a> S<line of quoted text" ) && expected.ends_with( "> K<b> S<1> ED " ) );
+    YAML_CHECK( GetStreamTranscript( yaml, 4096 ) == expected );
+  }
+}
+
+// Likewise for a block scalar, which is only assembled once a line ends it
+void TestLargeBlock()
+{
+  std::string text;
+  for( size_t i = 0; i < 100000; ++i )
+    text += ( i % 10 == 9 ) ? "\n" : "  line of block scalar text\n";
+  for( std::string_view header : { "|", ">", "|-", ">+", "|2" } )
+  {
+    std::string yaml = "a: ";
+    yaml.append( header ).append( "\n" ).append( text ).append( "b: 1\n" );
+    auto expected = GetTranscript( yaml );
+    YAML_CHECK( expected.starts_with( "SD K<a> S<line of block scalar text" ) && expected.ends_with( "> K<b> S<1> ED " ) );
+    YAML_CHECK( GetStreamTranscript( yaml, 4096 ) == expected );
+
+    // The block ends the text
+    yaml.resize( yaml.size() - 5 );
+    YAML_CHECK( GetStreamTranscript( yaml, 4096 ) == GetTranscript( yaml ) );
+  }
+}
+
+// Text split at any position reaches the handler as the same values
+void TestValues()
+{
+  std::string_view yaml = "key: plain value\nlist: [ 'it''s', \"a\\tb\" ]\n---\nnext: |\n  text\n...\nlast: 1\n";
+  constexpr std::string_view kExpected = "SD K<key> S<plain value> K<list> SS S<it's> S<a\tb> ES ED "
+                                         "SD K<next> S<text\n> ED SD K<last> S<1> ED ";
+  for( size_t split = 0; split <= yaml.size(); ++split )
+  {
+    VirtualTranscriptHandler handler;
+    YamlStreamParser parser( handler );
+    YAML_CHECK( parser.Feed( yaml.substr( 0, split ) ) );
+    YAML_CHECK( parser.Feed( yaml.substr( split ) ) );
+    YAML_CHECK( parser.Finish() );
+    YAML_CHECK( handler.GetTranscript() == kExpected );
+  }
+
+  // Feed reports an error in the text given so far
+  VirtualTranscriptHandler handler;
+  YamlStreamParser parser( handler );
+  YAML_CHECK( parser.Feed( "a: 1\n" ) );
+  YAML_CHECK( !parser.Feed( "b:\n\tc: 2\n" ) );
+  YAML_CHECK( handler.GetTranscript().starts_with( "SD K<a> S<1> K<b> E<" ) );
+}
+
+void TestErrors()
+{
+  CheckSame( "a: \"unterminated\n  text\n" );
+  CheckSame( "a: 'x' 'y'\nb: \"\\q\"\n" );
+  CheckSame( "a:\n\tb: 1\n" );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestEvents();
+  TestValues();
+  TestLargeQuoted();
+  TestLargeBlock();
+  TestErrors();
+  return YamlTest::GetExitCode();
+}
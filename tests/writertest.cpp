@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  writertest.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Checks the text YamlWriter and the Yaml::Create functions write, and that
+//  it reads back as the values written.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yaml.h"
+#include "yamltest.h"
+
+using namespace PKIsensee;
+
+namespace { // anonymous
+
+// Empty collections written with a key must read back as collections
+void TestWriter()
+{
+  std::string output;
+  YamlWriter writer( std::back_inserter( output ) );
+  writer.BeginMapping( "empty" );
+  writer.EndMapping();
+  writer.BeginSequence( "list" );
+  writer.EndSequence();
+  writer.BeginMapping( "full" );
+  writer.KeyValue( "k", "v" );
+  writer.EndMapping();
+  YAML_CHECK( output == "empty: {}\nlist: []\nfull:\n  k: v\n" );
+  YAML_CHECK( YamlTest::GetTranscript( output ) == "SD K<empty> SM EM K<list> SS ES K<full> SM K<k> S<v> EM ED " );
+
+  char buffer[ 8 ];
+  YamlWriter bounded( YamlBufferIterator( buffer, buffer + sizeof( buffer ) ) );
+  bounded.KeyValue( "a", "1" );
+  YAML_CHECK( !bounded.GetOutput().IsTruncated() );
+  YAML_CHECK( std::string_view( buffer, bounded.GetOutput().Get() ) == "a: 1\n" );
+  bounded.KeyValue( "b", "2" );
+  YAML_CHECK( bounded.GetOutput().IsTruncated() );
+  YAML_CHECK( bounded.GetOutput().Get() == buffer + sizeof( buffer ) );
+
+  // Numbers in their shortest form that reads back the same
+  YAML_CHECK( Yaml::CreateSequence( std::vector<int>{ 1, -20 } ) == "[1, -20]" );
+  YAML_CHECK( Yaml::CreateKeyValueSeq( "f", std::vector<double>{ 1.5, 0.1, 2.0 } ) == "f: [1.5, 0.1, 2]\n" );
+  YAML_CHECK( Yaml::CreateKeyValueSeq( "b", std::vector<bool>{ true, false } ) == "b: [true, false]\n" );
+  YAML_CHECK( Yaml::CreateSequence( std::vector<std::string>{ "a b", "c: d" } ) == "[a b, 'c: d']" );
+}
+
+} // end anonymous namespace
+
+int main()
+{
+  TestWriter();
+  return YamlTest::GetExitCode();
+}
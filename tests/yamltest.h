@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  yamltest.h
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Minimal checks shared by the test programs. Each program exits with a
+//  failure status if any check fails, for ctest.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "yaml.h"
+
+#define YAML_CHECK( expr ) PKIsensee::YamlTest::Check( ( expr ), #expr, __FILE__, __LINE__ )
+
+namespace PKIsensee::YamlTest
+{
+
+inline int& GetFailureCount()
+{
+  static int failureCount = 0;
+  return failureCount;
+}
+
+inline bool Check( bool isOk, const char* expr, const char* file, int line )
+{
+  if( !isOk )
+  {
+    std::fprintf( stderr, "%s(%d): check failed: %s\n", file, line, expr );
+    ++GetFailureCount();
+  }
+  return isOk;
+}
+
+inline int GetExitCode()
+{
+  return ( GetFailureCount() == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Document with a variety of constructs, repeated to the given number of
+// top-level records: keys of a mapping, or entries of a sequence
+inline std::string MakeDocument( size_t records, bool isSequence, bool isCrlf = false )
+{
+  std::string yaml;
+  const char* lineEnd = isCrlf ? "\r\n" : "\n";
+  auto addLine = [&]( const std::string& line )
+  {
+    yaml += line;
+    yaml += lineEnd;
+  };
+  for( size_t i = 0; i < records; ++i )
+  {
+    auto n = std::to_string( i );
+    if( isSequence )
+    {
+      addLine( "- id: " + n );
+      addLine( "  name: \"item\\t" + n + "\"" );
+      addLine( "  tags: [ a, 'b c', { d: " + n + " } ]" );
+      addLine( "  base: &base" + n + " { x: 1 }" );
+      addLine( "  copy: *base" + n );
+      addLine( "  text: |" );
+      addLine( "    line one" );
+      addLine( "    line two # not a comment" );
+      addLine( "  # comment" );
+      addLine( "  list:" );
+      addLine( "    - n: " + n );
+      addLine( "      m: plain scalar " + n );
+      addLine( "    - " + n );
+    }
+    else
+    {
+      addLine( "key" + n + ":" );
+      addLine( "  value: plain " + n + " # comment" );
+      addLine( "  quoted: 'it''s " + n + "'" );
+      addLine( "  flow: [ 1, 2," );
+      addLine( "    3, 4 ]" );
+      addLine( "  entries:" );
+      addLine( "  - &e" + n + " a" );
+      addLine( "  - *e" + n );
+      addLine( "folded" + n + ": >" );
+      addLine( "  folded" );
+      addLine( "  text" );
+      addLine( "" );
+    }
+  }
+  return yaml;
+}
+
+// Events as text, e.g. "SD SM K<a> S<1> EM ED ". With positions, each event
+// is followed by the parser's line and column, e.g. "K<a>@1:1 ".
+class TranscriptHandler : public YamlStaticHandler
+{
+public:
+
+  // The parser's type can't be named until the handler is complete
+  template <typename Parser>
+  void SetParser( const Parser& parser )
+  {
+    getPosition_ = [&parser]()
+    {
+      return std::to_string( parser.GetLine() ) + ":" + std::to_string( parser.GetCol() );
+    };
+  }
+
+  void onStartDocument() { Add( "SD" ); }
+  void onEndDocument() { Add( "ED" ); }
+  void onStartSequence() { Add( "SS" ); }
+  void onEndSequence() { Add( "ES" ); }
+  void onStartMapping() { Add( "SM" ); }
+  void onEndMapping() { Add( "EM" ); }
+  void onSequenceEntry() { Add( "-" ); }
+  void onTag( std::string_view tag ) { Add( "T", tag ); }
+  void onAnchor( std::string_view anchor ) { Add( "&", anchor ); }
+  bool onKey( std::string_view key ) { Add( "K", key ); return true; }
+  bool onScalar( std::string_view scalar ) { Add( "S", scalar ); return true; }
+
+  void onErrorCode( const YamlError& error )
+  {
+    errorCode = error.code;
+    hasError = true;
+    Add( "E", error.GetText() );
+  }
+
+  const std::string& GetTranscript() const
+  {
+    return transcript_;
+  }
+
+  YamlErrorCode errorCode = YamlErrorCode::Tab;
+  bool hasError = false;
+
+private:
+
+  void Add( std::string_view event )
+  {
+    transcript_.append( event );
+    if( getPosition_ )
+      transcript_.append( "@" ).append( getPosition_() );
+    transcript_.append( " " );
+  }
+
+  void Add( std::string_view event, std::string_view text )
+  {
+    transcript_.append( event ).append( "<" ).append( text ).append( ">" );
+    if( getPosition_ )
+      transcript_.append( "@" ).append( getPosition_() );
+    transcript_.append( " " );
+  }
+
+private:
+
+  std::string                    transcript_;
+  std::function<std::string()>   getPosition_;
+};
+
+// The tree as text, e.g. "{a: 1 list: [x {b: 2}]}"
+inline void AppendTree( const YamlNode& node, std::string& text )
+{
+  if( !node.key.empty() )
+    text.append( node.key ).append( ": " );
+  if( node.IsScalar() )
+  {
+    text.append( node.scalar );
+    return;
+  }
+  bool isSequence = ( node.type == YamlNode::Type::Sequence );
+  text.append( isSequence ? "[" : "{" );
+  bool isFirst = true;
+  for( const auto& child : node.GetChildren() )
+  {
+    if( !std::exchange( isFirst, false ) )
+      text.append( " " );
+    AppendTree( child, text );
+  }
+  text.append( isSequence ? "]" : "}" );
+}
+
+inline std::string GetTree( const YamlNode& node )
+{
+  std::string text;
+  AppendTree( node, text );
+  return text;
+}
+
+// Parses with Parse(), or with ParseChunked() for more than one thread
+inline std::string GetTranscript( std::string_view yaml, bool hasPositions = false, size_t threadCount = 1,
+                                  bool* isParsed = nullptr )
+{
+  TranscriptHandler handler;
+  BasicYamlParser<TranscriptHandler> parser( yaml, handler );
+  if( hasPositions )
+    handler.SetParser( parser );
+  bool isOk = ( threadCount == 1 ) ? parser.Parse() : parser.ParseChunked( threadCount );
+  if( isParsed != nullptr )
+    *isParsed = isOk;
+  return handler.GetTranscript();
+}
+
+} // end namespace PKIsensee::YamlTest
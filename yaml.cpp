@@ -16,460 +16,1882 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined( _M_X64 ) || defined( __SSE2__ )
+#define YAML_USE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 #include "yaml.h"
 
 using namespace PKIsensee;
+using namespace PKIsensee::Yaml::Detail;
 
 namespace { // anonymous
 
-constexpr size_t kAsciiTableSize = 256;
 constexpr size_t kInvalidPos = size_t( -1 );
-constexpr size_t kNoLevel = size_t( -1 );
-constexpr size_t kMaxScalarStringPrefixForErrorMsg = 12; // leading chars to print on error
 
-enum class TrimTrailingBlanks
+// Returns the position of the first character in scalar that requires quoting,
+// or kInvalidPos if there isn't one. With SSE2, whole 16-byte blocks of letters,
+// digits and spaces are accepted at once; only the remaining characters in a
+// block are checked against the lookup table.
+size_t FindFirstSpecial( std::string_view scalar )
 {
-  No,
-  Yes
-};
+  const char* start = scalar.data();
+  const char* end = start + scalar.size();
+  const char* curr = start;
+#if defined( YAML_USE_SSE2 )
+  auto inRange = []( __m128i block, char lower, char upper )
+  {
+    return _mm_and_si128( _mm_cmpgt_epi8( block, _mm_set1_epi8( lower - 1 ) ),
+                          _mm_cmplt_epi8( block, _mm_set1_epi8( upper + 1 ) ) );
+  };
+  constexpr std::ptrdiff_t kBlockSize = sizeof( __m128i );
+  constexpr uint32_t kAllChars = ( 1u << kBlockSize ) - 1;
+  for( ; end - curr >= kBlockSize; curr += kBlockSize )
+  {
+    __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( curr ) );
+    __m128i safe = _mm_or_si128( _mm_or_si128( inRange( block, 'a', 'z' ), inRange( block, 'A', 'Z' ) ),
+                                 _mm_or_si128( inRange( block, '0', '9' ), _mm_cmpeq_epi8( block, _mm_set1_epi8( ' ' ) ) ) );
+    auto unsafe = ~static_cast<uint32_t>( _mm_movemask_epi8( safe ) ) & kAllChars;
+    for( ; unsafe != 0; unsafe &= unsafe - 1 )
+    {
+      auto i = std::countr_zero( unsafe );
+      if( IsCharClass( curr[ i ], kSpecialClass ) )
+        return static_cast<size_t>( curr - start ) + i;
+    }
+  }
+#endif
+  for( ; curr < end; ++curr )
+  {
+    if( IsCharClass( *curr, kSpecialClass ) )
+      return static_cast<size_t>( curr - start );
+  }
+  return kInvalidPos;
+}
 
-template <typename T>
-static bool CharIsIn( char c, const T& validSet )
+// Returns the first character in [curr, end) that is one of chars, or end if
+// there isn't one. charClass must contain exactly the given chars.
+template <size_t N>
+const char* FindFirstOf( const char* curr, const char* end, 
+                         [[maybe_unused]] const std::array<char, N>& chars, CharClass charClass )
 {
-  return std::any_of( validSet.begin(), validSet.end(), [&]( char e ) { return c == e; } );
+#if defined( YAML_USE_SSE2 )
+  constexpr std::ptrdiff_t kBlockSize = sizeof( __m128i );
+  for( ; end - curr >= kBlockSize; curr += kBlockSize )
+  {
+    __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( curr ) );
+    __m128i found = _mm_setzero_si128();
+    for( char c : chars )
+      found = _mm_or_si128( found, _mm_cmpeq_epi8( block, _mm_set1_epi8( c ) ) );
+    auto mask = static_cast<uint32_t>( _mm_movemask_epi8( found ) );
+    if( mask != 0 )
+      return curr + std::countr_zero( mask );
+  }
+#endif
+  for( ; curr < end; ++curr )
+  {
+    if( IsCharClass( *curr, charClass ) )
+      return curr;
+  }
+  return end;
 }
 
-std::string_view ExtractStr( const char* start, const char* end, TrimTrailingBlanks trimTrailingBlanks )
+// Quotes and comments only count at the start of a token
+bool IsTokenStart( const char* curr )
 {
-  assert( start != nullptr && end != nullptr );
-  assert( start <= end );
-  std::string_view str( start, static_cast<size_t>(end - start) );
-  if( trimTrailingBlanks == TrimTrailingBlanks::Yes )
-    str.remove_suffix( str.size() - ( str.find_last_not_of( ' ' ) + 1 ) );
-  return str;
+  switch( curr[ -1 ] )
+  {
+  case '[':
+  case '{':
+  case ',':
+    return true;
+  default:
+    return IsCharClass( curr[ -1 ], kWhiteClass );
+  }
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-} // anonymous namespace
-
-///////////////////////////////////////////////////////////////////////////////
-
-Yaml::Special Yaml::GetSpecialChars( std::string_view scalar )
+// Appends the UTF-8 encoding of a code point
+void AppendUtf8( uint32_t codePoint, std::string& str )
 {
-  if( scalar.empty() )
-    return Yaml::Special(false);
+  if( codePoint < 0x80 )
+  {
+    str += static_cast<char>( codePoint );
+  }
+  else if( codePoint < 0x800 )
+  {
+    str += static_cast<char>( 0xC0 | ( codePoint >> 6 ) );
+    str += static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+  }
+  else if( codePoint < 0x10000 )
+  {
+    str += static_cast<char>( 0xE0 | ( codePoint >> 12 ) );
+    str += static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+    str += static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+  }
+  else
+  {
+    str += static_cast<char>( 0xF0 | ( codePoint >> 18 ) );
+    str += static_cast<char>( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) );
+    str += static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+    str += static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+  }
+}
 
-  // If already quoted, ignore
-  if( ( scalar.size() > 2 ) &&
-      ( scalar.front() == '\'' || scalar.front() == '\"' ) &&
-      ( scalar.front() == scalar.back() ) )
-    return Yaml::Special(false);
+// Decodes the escape sequence following the backslash at text[ pos ], advancing
+// pos to its last character. Returns false if the sequence is invalid.
+bool DecodeEscape( std::string_view text, size_t& pos, std::string& str )
+{
+  if( ++pos == text.size() )
+    return false;
+  size_t hexDigits = 0u;
+  switch( text[ pos ] )
+  {
+  case '0':  str += '\0';   return true;
+  case 'a':  str += '\a';   return true;
+  case 'b':  str += '\b';   return true;
+  case 't':
+  case '\t': str += '\t';   return true;
+  case 'n':  str += '\n';   return true;
+  case 'v':  str += '\v';   return true;
+  case 'f':  str += '\f';   return true;
+  case 'r':  str += '\r';   return true;
+  case 'e':  str += '\x1B'; return true;
+  case ' ':
+  case '\"':
+  case '/':
+  case '\\': str += text[ pos ]; return true;
+  case 'N':  AppendUtf8( 0x85, str );   return true; // next line
+  case '_':  AppendUtf8( 0xA0, str );   return true; // non-breaking space
+  case 'L':  AppendUtf8( 0x2028, str ); return true; // line separator
+  case 'P':  AppendUtf8( 0x2029, str ); return true; // paragraph separator
+  case 'x':  hexDigits = 2u; break;
+  case 'u':  hexDigits = 4u; break;
+  case 'U':  hexDigits = 8u; break;
+  case '\r':
+  case '\n': // escaped line break; the text continues after any indentation
+    if( text[ pos ] == '\r' && pos + 1 < text.size() && text[ pos + 1 ] == '\n' )
+      ++pos;
+    while( pos + 1 < text.size() && ( text[ pos + 1 ] == ' ' || text[ pos + 1 ] == '\t' ) )
+      ++pos;
+    return true;
+  default:
+    return false;
+  }
 
-  // Build ASCII index table from scalar. Once the string is scanned, the table
-  // indicates what characters were found and the first position where the
-  // given character occurred.
-  struct Letter
+  auto parseHex = [&]( size_t hexPos, uint32_t& codePoint )
   {
-    size_t firstPos = 0;
-    bool found = false;
+    if( hexDigits > text.size() - hexPos )
+      return false;
+    const char* start = text.data() + hexPos;
+    auto [ ptr, ec ] = std::from_chars( start, start + hexDigits, codePoint, 16 );
+    return ec == std::errc() && ptr == start + hexDigits && codePoint <= 0x10FFFF;
   };
-  std::array<Letter, kAsciiTableSize> ascii;
-  for( size_t i = 0; i < scalar.size(); ++i )
+  uint32_t codePoint = 0u;
+  if( !parseHex( pos + 1, codePoint ) )
+    return false;
+  pos += hexDigits;
+
+  // A UTF-16 surrogate pair, e.g. \uD83D\uDE00, is a single code point
+  uint32_t lowSurrogate = 0u;
+  if( hexDigits == 4u && codePoint >= 0xD800 && codePoint <= 0xDBFF &&
+      text.substr( pos + 1, 2 ) == "\\u" && parseHex( pos + 3, lowSurrogate ) &&
+      lowSurrogate >= 0xDC00 && lowSurrogate <= 0xDFFF )
   {
-    // Treat as unsigned 8-bit to ensure characters map to ASCII; 
-    // required for unusual chars with high bit set
-    uint8_t c = static_cast<uint8_t>( scalar[ i ] );
-    if( ascii[ c ].firstPos == 0 )
-    {
-      ascii[ c ].firstPos = i;
-      ascii[ c ].found = true;
-    }
+    codePoint = 0x10000 + ( ( codePoint - 0xD800 ) << 10 ) + ( lowSurrogate - 0xDC00 );
+    pos += 2 + hexDigits;
   }
+  AppendUtf8( codePoint, str );
+  return true;
+}
 
-  // Any character less than' ' (0x020) or greater than 'z' (0x7A) is unusual
-  constexpr char kLowerBound = ' ';
-  constexpr char kUpperBound = 'z';
+// from_chars reports both overflow and underflow of a float as out of range.
+// The decimal exponent of the first significant digit tells them apart, e.g.
+// 12.5e3 is 1.25e4 and 0.005 is 5e-3. The text matched the float syntax.
+bool IsFloatOverflow( std::string_view unsignedStr )
+{
+  auto expPos = unsignedStr.find_first_of( "eE" );
+  int64_t exponent = 0;
+  if( expPos != std::string_view::npos )
+  {
+    const char* expStart = unsignedStr.data() + expPos + 1;
+    const char* expEnd = unsignedStr.data() + unsignedStr.size();
+    expStart += ( *expStart == '+' );
+    if( std::from_chars( expStart, expEnd, exponent ).ec != std::errc() ) // exponent beyond int64_t
+      return *expStart != '-';
+  }
+  auto mantissa = unsignedStr.substr( 0, expPos );
+  auto dotPos = std::min( mantissa.find( '.' ), mantissa.size() );
+  auto firstDigit = mantissa.find_first_of( "123456789" );
+  if( firstDigit == std::string_view::npos ) // zero is never out of range
+    return false;
+  int64_t magnitude = ( firstDigit < dotPos ) ? int64_t( dotPos - firstDigit ) - 1
+                                              : int64_t( dotPos ) - int64_t( firstDigit );
+  return exponent > 0 ? magnitude > -exponent : exponent + magnitude > 0; // without overflowing
+}
 
-  // Characters in the 0x20 - 0x7A range are also special YAML values:
-  constexpr std::array kSpecialChar = {
-    '!', '\"', '#', '$', '%', '&', '\'', '*', ',', '-', 
-    '/', ':', '<', '=', '>', '?', '@', '[', '\\', ']', '`'
-  };
+// Resolves scalars starting with a digit, sign or '.' to int or float
+void DecodeNumber( std::string_view scalar, Yaml::TypedScalar& typed )
+{
+  const char* start = scalar.data();
+  const char* end = start + scalar.size();
 
-  // Find the special character at the lowest position
-  size_t lowestPosition = kInvalidPos;
-  size_t firstSingleQuote = kInvalidPos;
-  size_t firstDoubleQuote = kInvalidPos;
-  for( size_t c = 0; c < ascii.size(); ++c )
+  // Hexadecimal and octal integers are unsigned; those too large for int64_t
+  // are floats, like decimal integers
+  if( scalar.size() > 2 && scalar[ 0 ] == '0' && ( scalar[ 1 ] == 'x' || scalar[ 1 ] == 'o' ) )
   {
-    Letter letter = ascii[ c ];
-    if( letter.found )
+    int base = ( scalar[ 1 ] == 'x' ) ? 16 : 8;
+    uint64_t value = 0u;
+    auto [ ptr, ec ] = std::from_chars( start + 2, end, value, base );
+    if( ptr != end || ( ec != std::errc() && ec != std::errc::result_out_of_range ) )
+      return;
+    if( ec == std::errc() && value <= uint64_t( std::numeric_limits<int64_t>::max() ) )
     {
-      if( ( c < kLowerBound ) ||
-          ( c > kUpperBound ) ||
-          ( std::any_of( kSpecialChar.begin(), kSpecialChar.end(), [&]( size_t e ) { return c == e; } ) ) )
-      {
-        if( letter.firstPos < lowestPosition )
-          lowestPosition = letter.firstPos;
-      }
-      if( c == '\'' )
-        firstSingleQuote = letter.firstPos;
-      if( c == '"' )
-        firstDoubleQuote = letter.firstPos;
+      typed.type = Yaml::ScalarType::Int;
+      typed.intValue = static_cast<int64_t>( value );
+      return;
     }
+    typed.type = Yaml::ScalarType::Float;
+    for( const char* digit = start + 2; digit < end; ++digit )
+    {
+      int digitValue = 0;
+      std::from_chars( digit, digit + 1, digitValue, base );
+      typed.floatValue = typed.floatValue * base + digitValue;
+    }
+    return;
   }
 
-  if( lowestPosition == kInvalidPos ) // no special characters
-    return Yaml::Special(false);
+  // At most one sign, followed by a digit or '.'
+  bool isNegative = ( *start == '-' );
+  bool hasSign = isNegative || ( *start == '+' );
+  std::string_view unsignedStr( start + hasSign, end );
+  if( unsignedStr.empty() || ( unsignedStr.front() != '.' && ( unsignedStr.front() < '0' || unsignedStr.front() > '9' ) ) )
+    return;
+  if( *start == '+' ) // from_chars accepts a leading '-' but not '+'
+    ++start;
 
-  Yaml::Special special;
-  special.firstSpecialPos = lowestPosition;
-  special.firstSingleQuote = firstSingleQuote;
-  special.firstDoubleQuote = firstDoubleQuote;
-  special.hasSpecialChars = true;
-  special.specialChar = scalar[ lowestPosition ];
-  return special;
+  if( unsignedStr == ".inf" || unsignedStr == ".Inf" || unsignedStr == ".INF" )
+  {
+    typed.type = Yaml::ScalarType::Float;
+    typed.floatValue = isNegative ? -std::numeric_limits<double>::infinity() 
+                                  :  std::numeric_limits<double>::infinity();
+    return;
+  }
+  if( scalar == ".nan" || scalar == ".NaN" || scalar == ".NAN" )
+  {
+    typed.type = Yaml::ScalarType::Float;
+    typed.floatValue = std::numeric_limits<double>::quiet_NaN();
+    return;
+  }
+
+  auto [ intEnd, intEc ] = std::from_chars( start, end, typed.intValue );
+  if( intEc == std::errc() && intEnd == end )
+  {
+    typed.type = Yaml::ScalarType::Int;
+    return;
+  }
+
+  // The from_chars floating point syntax matches the core schema once the
+  // sign and the first character have been checked; out of range integers
+  // end up here too
+  typed.intValue = 0;
+  auto [ floatEnd, floatEc ] = std::from_chars( start, end, typed.floatValue );
+  if( floatEnd != end )
+  {
+    typed.floatValue = 0.0;
+    return;
+  }
+  if( floatEc == std::errc::result_out_of_range ) // too large is infinite; too small is zero
+  {
+    typed.floatValue = IsFloatOverflow( unsignedStr ) ? std::numeric_limits<double>::infinity() : 0.0;
+    if( isNegative )
+      typed.floatValue = -typed.floatValue;
+  }
+  else if( floatEc != std::errc() )
+  {
+    typed.floatValue = 0.0;
+    return;
+  }
+  typed.type = Yaml::ScalarType::Float;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//
-// Guarantees the result can be embedded in a YAML file; adding quotes if needed
 
-std::string Yaml::CreateSafeScalar( std::string_view scalar )
+// Text surrounding the detail of each error, indexed by YamlErrorCode
+struct ErrorText
 {
-  Yaml::Special special = GetSpecialChars( scalar );
-  char quote = '\0';
-  if( special.hasSpecialChars )
-  {
-    // Ensure scalar doesn't have quotes of two different types
-    assert( !( special.firstDoubleQuote < kInvalidPos &&
-               special.firstSingleQuote < kInvalidPos ) );
+  std::string_view prefix;
+  std::string_view suffix;
+};
 
-    quote = '\''; // default to single character quote
-    if( special.firstSingleQuote < kInvalidPos )
-      quote = '\"';
-  }
+constexpr ErrorText kErrorText[] =
+{
+  { "Unable to open file", "" },
+  { "Avoid tabs in YAML files", "" },
+  { "", " directive not supported" },
+  { "Maximum nesting depth exceeded", "" },
+  { "Too many closing braces or brackets", "" },
+  { "Invalid escape sequence <", ">" },
+  { "Unterminated quoted scalar <", "...>" },
+  { "Block scalars not allowed in flow collections", "" },
+  { "Invalid block scalar header", "" },
+  { "Missing anchor name", "" },
+  { "Missing alias name", "" },
+  { "Aliases can't be used as keys", "" },
+  { "Unknown alias <", ">" },
+  { "Alias expansion limit exceeded", "" },
+  { "Verbatim tag missing >", "" },
+  { "Named tag handles not supported", "" },
+  { "Invalid scalar for tag <", ">" },
+};
+static_assert( std::size( kErrorText ) == size_t( YamlErrorCode::InvalidTaggedScalar ) + 1 );
 
-  std::string yaml;
-  if( quote )
-    yaml += quote;
-  yaml += scalar;
-  if( quote )
-    yaml += quote;
-  return yaml;
-}
+} // anonymous namespace
 
-std::string Yaml::CreateKeyValue( std::string_view tag, std::string_view scalar )
+///////////////////////////////////////////////////////////////////////////////
+
+std::string_view YamlError::GetText() const
 {
-  std::string yaml;
-  yaml += tag;
-  yaml += ": ";
-  yaml += CreateSafeScalar( scalar );
-  yaml += '\n';
-  return yaml;
+  const auto& errorText = kErrorText[ size_t( code ) ];
+  const size_t capacity = text_.size() - 1; // leaving room for the null
+  size_t size = 0u;
+  auto append = [&]( std::string_view str )
+  {
+    size_t count = std::min( str.size(), capacity - size );
+    std::copy_n( str.data(), count, text_.data() + size );
+    size += count;
+  };
+
+  // A long detail is truncated so the suffix still fits
+  append( errorText.prefix );
+  append( detail.substr( 0, capacity - std::min( capacity, size + errorText.suffix.size() ) ) );
+  append( errorText.suffix );
+  text_[ size ] = '\0';
+  return { text_.data(), size };
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-YamlParser::YamlParser( std::string_view yaml, YamlHandler& handler ) : 
-  curr_( yaml.data() ),
-  end_( yaml.data() + yaml.size() ),
-  yamlHandler_( handler )
+const char* Yaml::Detail::FindEndScalar( const char* curr, const char* end )
 {
-  yamlStack_.push( Indent{} ); // avoid having to check for empty stack
+  return FindFirstOf( curr, end, kEndScalar, kEndScalarClass );
 }
 
-bool YamlParser::Parse()
+void Yaml::Detail::StructuralIndex::Build( std::string_view text )
 {
-  yamlHandler_.onStartDocument();
-  assert( curr_ != nullptr && end_ != nullptr );
-  for( ; curr_ < end_; ++curr_, ++col_ )
+  base_ = text.data();
+  bits_.assign( ( text.size() + kWordBits - 1 ) / kWordBits, 0u );
+  const char* curr = text.data();
+  const char* end = text.data() + text.size();
+  uint64_t* word = bits_.data();
+#if defined( YAML_USE_SSE2 )
+  // Four 16-byte blocks make each 64-bit word
+  constexpr std::ptrdiff_t kBlockSize = sizeof( __m128i );
+  constexpr std::ptrdiff_t kWordSize = kWordBits;
+  auto classify = []( const char* block )
+  {
+    __m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>( block ) );
+    __m128i found = _mm_setzero_si128();
+    for( char c : kEndScalar )
+      found = _mm_or_si128( found, _mm_cmpeq_epi8( chars, _mm_set1_epi8( c ) ) );
+    return static_cast<uint64_t>( static_cast<uint32_t>( _mm_movemask_epi8( found ) ) );
+  };
+  for( ; end - curr >= kWordSize; curr += kWordSize, ++word )
+  {
+    *word = classify( curr ) | 
+            ( classify( curr + kBlockSize ) << 16 ) |
+            ( classify( curr + kBlockSize * 2 ) << 32 ) |
+            ( classify( curr + kBlockSize * 3 ) << 48 );
+  }
+#endif
+  for( size_t bit = 0u; curr < end; ++curr )
   {
-    if( col_ == 1 ) // handle new line indentation
+    if( IsCharClass( *curr, kEndScalarClass ) )
+      *word |= uint64_t( 1 ) << bit;
+    if( ++bit == kWordBits )
     {
-      auto indent = GetIndent();
-      if( indent.level == kNoLevel )
-        ;
-      else if( indent.level > yamlStack_.top().level )
-        Push( indent );
-      else while( indent.level < yamlStack_.top().level )
-      {
-        if( !Pop() )
-          return false;
-      }
+      bit = 0u;
+      ++word;
     }
-    switch( *curr_ )
+  }
+}
+
+const char* Yaml::Detail::SkipValue( const char* curr, const char* end, size_t keyLevel, 
+                                     bool isFlow, size_t& lines )
+{
+  size_t depth = 0u; // brackets opened within the value
+  bool isBlockScalar = false; // only indentation matters within block scalars
+  for( ; ( curr = FindFirstOf( curr, end, kSkipValue, kSkipValueClass ) ) < end; ++curr )
+  {
+    if( isBlockScalar && *curr != '\n' )
+      continue;
+    switch( *curr )
     {
-    case '-': // serves multiple purposes
-      switch( PeekNext() )
-      {
-      case ' ': // "- " mapping entry
-        yamlHandler_.onStartMapping();
-        SkipSpaces();
-        break;
-      case '-': // "---" start of new document
-        SkipStartDocument();
-        break;
-      default:  // "-X" node, e.g. "-1234"
-        if( !ParseNode() )
-          return false;
-        break;
-      }
-      break;
-    case ':': // mapping value
-    case ',': // flow collection separator
-      SkipSpaces();
-      break;
-    case '[': // sequence start, e.g. [ one, two, three ]
-      completeKeyValuePair_ = true;
-      yamlHandler_.onStartSequence();
-      SkipSpaces();
+    case '|':
+    case '>':
+      // Indicators follow a key or sequence entry, e.g. "key: |" or "- >"
+      isBlockScalar = ( depth == 0 && !isFlow && curr[ -1 ] == ' ' && 
+                        ( curr[ -2 ] == ':' || curr[ -2 ] == '-' ) );
       break;
-    case ']': // sequence end
-      HandleMissingNull();
-      yamlHandler_.onEndSequence();
-      SkipSpaces();
+    case '[':
+    case '{':
+      ++depth;
       break;
-    case '{': // mapping start, e.g. { key1: value1, key2 : value2 }
-      completeKeyValuePair_ = true;
-      yamlHandler_.onStartMapping();
-      SkipSpaces();
+    case ']':
+    case '}':
+      if( depth != 0 )
+        --depth;
+      else if( isFlow ) // closes the collection containing the key
+        return curr;
       break;
-    case '}': // mapping end
-      HandleMissingNull();
-      yamlHandler_.onEndMapping();
-      SkipSpaces();
+    case ',':
+      if( depth == 0 && isFlow )
+        return curr;
       break;
-
-    case '#': // comment
-    case '%': // directive line
-      SkipLine();
-      break;
-    case '\n': // linefeed
-      ++line_;
-      col_ = 0;
+    case '#':
+      if( IsTokenStart( curr ) )
+        curr = std::find( curr, end, '\n' ) - 1;
       break;
-    case '\r': // carriage return
-    case ' ':  // space
-      break;
-    case '\0': // null character: early out
-      end_ = curr_;
+    case '\'':
+    case '\"':
+      if( IsTokenStart( curr ) )
+      {
+        // Find the closing quote, counting any line ends within the scalar
+        char quote = *curr;
+        for( ++curr; curr < end && *curr != quote; ++curr )
+        {
+          if( *curr == '\\' && quote == '\"' && curr + 1 < end )
+            ++curr;
+          lines += ( *curr == '\n' );
+        }
+        if( curr == end )
+          return end;
+      }
       break;
-    case '\t': // tab
-      return Error( "Avoid tabs in YAML files" );
-
-    // Characters unsupported by this implementation
-    case '|':  // literal scalar
-    case '>':  // folder block scalar
-    case '?':  // mapping key
-    case '&':  // node anchor
-    case '*':  // alias
-    case '!':  // tag handle
-    case '@':  // reserved
-    case '`':  // reserved
-      return Error( std::string( 1, *curr_ ) + std::string( " directive not supported" ) );
-
-    case '\'': // single-quoted scalar
-    case '\"': // double-quoted scalar
-    default:   // everything else
-      if( !ParseNode() )
-        return false;
+    case '\n':
+      if( depth == 0 && !isFlow )
+      {
+        // The block value ends unless the next line is blank, a comment or
+        // indented beyond the key
+        const char* lineStart = curr + 1;
+        const char* content = lineStart;
+        for( ; content < end && IsCharClass( *content, kIndentClass ); ++content )
+          ;
+        if( IsDocumentMarker( lineStart, end ) )
+          return curr;
+        if( content < end && !IsCharClass( *content, kIgnoreLineClass ) &&
+            static_cast<size_t>( content - lineStart ) <= keyLevel )
+          return curr;
+        curr = content - 1;
+      }
+      ++lines;
       break;
     }
   }
-  while( yamlStack_.size() > 1 )
-    Pop();
-  yamlHandler_.onEndDocument();
-  return true;
+  return end;
 }
 
-///////////////////////////////////////////////////////////////////////////////
+const char* Yaml::Detail::FindEndQuoted( const char* curr, const char* end, char quote )
+{
+  if( quote == '\"' )
+    return FindFirstOf( curr, end, kEndDoubleQuoted, kEndDoubleQuotedClass );
+  auto pos = std::string_view( curr, static_cast<size_t>( end - curr ) ).find( quote );
+  return ( pos == std::string_view::npos ) ? end : curr + pos;
+}
 
-bool YamlParser::Error( std::string_view errMessage ) const
+bool Yaml::Detail::DecodeQuoted( std::string_view text, char quote, std::string& str, size_t& errPos )
 {
-  yamlHandler_.onError( errMessage, line_, col_ );
-  return false; // all syntax issues are sufficient to quit
+  // Copy the text between escapes and line breaks in runs
+  str.reserve( str.size() + text.size() );
+  char escape = ( quote == '\"' ) ? '\\' : '\'';
+  const char stops[] = { escape, '\n', '\0' };
+  size_t pos = 0u;
+  for( size_t next; ( next = text.find_first_of( stops, pos ) ) != std::string_view::npos; pos = next + 1 )
+  {
+    if( text[ next ] == '\n' )
+    {
+      // Folding drops the blanks around a line break, and joins the lines
+      // with a space, or with a line end for each empty line between them
+      auto run = text.substr( pos, next - pos );
+      str += run.substr( 0, run.find_last_not_of( " \t\r" ) + 1 );
+      size_t emptyLines = 0u;
+      for( ; ( next = text.find_first_not_of( " \t\r", next + 1 ) ) != std::string_view::npos &&
+             text[ next ] == '\n'; ++emptyLines )
+        ;
+      str.append( std::max( emptyLines, size_t( 1 ) ), ( emptyLines == 0 ) ? ' ' : '\n' );
+      if( next == std::string_view::npos )
+        return true;
+      --next; // the next run starts at the text of the line
+      continue;
+    }
+    str += text.substr( pos, next - pos );
+    if( quote == '\'' ) // only '' can appear within single quotes
+    {
+      assert( next + 1 < text.size() && text[ next + 1 ] == '\'' );
+      str += quote;
+      ++next;
+    }
+    else
+    {
+      errPos = next;
+      if( !DecodeEscape( text, next, str ) )
+        return false;
+    }
+  }
+  str += text.substr( pos );
+  return true;
 }
 
-void YamlParser::Push( Indent indent )
+Yaml::Detail::BlockScalar Yaml::Detail::ParseBlockScalar( const char* curr, const char* end,
+                                                          size_t parentIndent, std::string& scratch )
 {
-  completeKeyValuePair_ = true;
-  yamlStack_.push( indent );
-  indent.isSequence ? yamlHandler_.onStartSequence() : yamlHandler_.onStartMapping();
+  BlockScalar block;
+  bool isFolded = ( *curr == '>' );
+
+  // Header: optional indentation and chomping indicators in either order,
+  // then an optional comment
+  size_t indent = 0u; // 0 until detected from the first content line
+  char chomp = '\0';  // '-' strips trailing line ends, '+' keeps them
+  for( ++curr; curr < end; ++curr )
+  {
+    if( indent == 0 && *curr >= '1' && *curr <= '9' )
+      indent = parentIndent + static_cast<size_t>( *curr - '0' );
+    else if( chomp == '\0' && ( *curr == '-' || *curr == '+' ) )
+      chomp = *curr;
+    else
+      break;
+  }
+  for( ; curr < end && *curr == ' '; ++curr )
+    ;
+  if( curr < end && *curr == '#' && IsCharClass( curr[ -1 ], kWhiteClass ) )
+    curr = std::find( curr, end, '\n' );
+  if( curr < end && *curr == '\r' )
+    ++curr;
+  if( curr < end && *curr != '\n' )
+    return block;
+
+  // Assemble the content in scratch, noting whether a view of the source
+  // would give the same result
+  scratch.clear();
+  std::string_view firstLine; // text of a leading content line
+  size_t contentLines = 0u;
+  size_t emptyLines = 0u;     // since the last content line
+  bool isMoreIndented = false;
+  bool hasFinalBreak = false;
+  const char* lineStart = end;
+  if( curr < end )
+  {
+    lineStart = curr + 1;
+    ++block.lines;
+  }
+  for( ; lineStart < end; lineStart = std::min( lineStart, end ) )
+  {
+    const char* text = lineStart;
+    for( ; text < end && *text == ' '; ++text )
+      ;
+    auto spaces = static_cast<size_t>( text - lineStart );
+    const char* lineEnd = std::find( text, end, '\n' );
+    const char* textEnd = ( lineEnd > text && lineEnd[ -1 ] == '\r' ) ? lineEnd - 1 : lineEnd;
+    bool isBlank = ( text == textEnd );
+    if( !isBlank )
+    {
+      if( indent == 0 ) // the first content line sets the indentation
+      {
+        if( spaces <= parentIndent )
+          break;
+        indent = spaces;
+      }
+      if( spaces < indent )
+        break;
+    }
+
+    if( isBlank && ( indent == 0 || spaces <= indent ) )
+    {
+      if( lineEnd == end ) // trailing spaces without a line end
+        break;
+      ++emptyLines;
+    }
+    else
+    {
+      // Folding joins adjacent lines with a space, and turns each empty line
+      // between them into a line end; more indented lines aren't folded
+      std::string_view lineText( lineStart + indent, static_cast<size_t>( textEnd - lineStart ) - indent );
+      bool isLineMoreIndented = !lineText.empty() && ( lineText.front() == ' ' || lineText.front() == '\t' );
+      if( contentLines == 0 )
+        scratch.append( emptyLines, '\n' );
+      else if( isFolded && !isMoreIndented && !isLineMoreIndented )
+        scratch.append( std::max( emptyLines, size_t( 1 ) ), ( emptyLines == 0 ) ? ' ' : '\n' );
+      else
+        scratch.append( emptyLines + 1, '\n' );
+      scratch += lineText;
+
+      if( contentLines == 0 && emptyLines == 0 )
+        firstLine = lineText;
+      ++contentLines;
+      emptyLines = 0u;
+      isMoreIndented = isLineMoreIndented;
+      hasFinalBreak = ( lineEnd < end );
+    }
+    if( lineEnd < end )
+      ++block.lines;
+    lineStart = lineEnd + 1;
+  }
+  block.next = std::min( lineStart, end );
+  block.indent = indent;
+
+  // Chomping: clip keeps the final line end; keep adds any trailing empty lines
+  if( contentLines != 0 && chomp != '-' && hasFinalBreak )
+    scratch += '\n';
+  if( chomp == '+' )
+    scratch.append( emptyLines, '\n' );
+
+  // A single line is usable straight from the source, unless it ends in
+  // "\r\n" or keeps trailing empty lines
+  block.str = scratch;
+  if( contentLines == 1 && !firstLine.empty() )
+  {
+    if( chomp == '-' || !hasFinalBreak )
+      block.str = firstLine;
+    else if( firstLine.data()[ firstLine.size() ] == '\n' && scratch.size() == firstLine.size() + 1 )
+      block.str = std::string_view( firstLine.data(), scratch.size() );
+  }
+  return block;
 }
 
-bool YamlParser::Pop()
+const char* Yaml::Detail::FindBlockEnd( const char* curr, const char* end, size_t indent )
 {
-  if( yamlStack_.size() == 1 )
-    return Error( "Too many closing braces or brackets" );
-  HandleMissingNull();
-  yamlStack_.top().isSequence ? yamlHandler_.onEndSequence() : yamlHandler_.onEndMapping();
-  yamlStack_.pop();
-  return true;
+  // Blank lines and lines indented at least as far continue the block
+  while( curr < end )
+  {
+    const char* text = curr;
+    for( ; text < end && *text == ' '; ++text )
+      ;
+    const char* lineEnd = std::find( text, end, '\n' );
+    if( lineEnd == end ) // incomplete line
+      return curr;
+    bool isBlank = ( text == lineEnd ) || ( *text == '\r' && text + 1 == lineEnd );
+    if( !isBlank && static_cast<size_t>( text - curr ) < indent )
+      return curr;
+    curr = lineEnd + 1;
+  }
+  return end;
 }
 
-char YamlParser::PeekNext() const
+void Yaml::Detail::AnchorRecorder::SetPending( std::string_view anchor )
 {
-  return ( curr_ + 1 >= end_ ) ? '\0' : *( curr_ + 1 );
+  pending_ = anchor;
+  isPending_ = true;
 }
 
-YamlParser::Indent YamlParser::GetIndent()
+void Yaml::Detail::AnchorRecorder::Record( EventType type, std::string_view str, YamlScalarStyle style )
 {
-  // Skip all leading spaces and dashes to determine indentation level
-  constexpr std::array kIndentChars = { ' ', '-' };
-  Indent indent;
-  for( ; curr_ < end_ && CharIsIn( *curr_, kIndentChars ); ++curr_, ++indent.level )
+  bool isStart = ( type == EventType::StartSequence || type == EventType::StartMapping );
+  bool isEnd = ( type == EventType::EndSequence || type == EventType::EndMapping );
+  if( isPending_ )
   {
-    if( *curr_ == '-' )
-      indent.isSequence = true;
+    isPending_ = false;
+    if( isEnd || type == EventType::SequenceEntry ) // the anchored node is missing, e.g. "[ &a ]" or "- &a\n- b"
+      SetAnchor( pending_, Range{} );
+    else
+      recordings_.push_back( { pending_, events_.size(), 0u } );
   }
+  if( recordings_.empty() )
+    return;
 
-  // If this line doesn't have anything interesting because it's empty or
-  // just a comment, then flag it to be ignored
-  constexpr std::array kIgnoreIndent = { '\r', '\n', '#' };
-  if( CharIsIn( *curr_, kIgnoreIndent ) )
-    indent.level = kNoLevel;
+  // Text replayed by an alias is already recorded, so it's referenced again
+  // rather than copied into each enclosing anchored node
+  if( str.data() >= text_.data() && str.data() + str.size() <= text_.data() + text_.size() )
+  {
+    events_.push_back( { type, style, static_cast<size_t>( str.data() - text_.data() ), str.size() } );
+  }
+  else
+  {
+    events_.push_back( { type, style, text_.size(), str.size() } );
+    text_ += str;
+  }
 
-  return indent;
+  // A recording is complete once the collections it opened are closed again.
+  // Nested anchors have their own recordings overlapping their parent's.
+  std::erase_if( recordings_, [&]( Recording& rec )
+  {
+    if( isStart )
+      ++rec.depth;
+    else if( isEnd && rec.depth != 0 )
+      --rec.depth;
+    if( rec.depth != 0 || type == EventType::Tag ) // a tag is followed by its node
+      return false;
+    SetAnchor( rec.anchor, Range{ rec.firstEvent, events_.size() - rec.firstEvent } );
+    return true;
+  } );
 }
 
-bool YamlParser::SkipStartDocument()
+const Yaml::Detail::AnchorRecorder::Range* Yaml::Detail::AnchorRecorder::Find( std::string_view anchor ) const
 {
-  // Three dashes --- signifies the start of a new YAML doc
-  // This implementation ignores multiple YAML docs within a single parsing segment
-  auto dashCount = 1;
-  for( ++curr_; ( curr_ < end_ ) && ( *curr_ == '-' ) && ( dashCount < 3 ); ++curr_, ++dashCount )
-    ;
-  col_ += dashCount;
-  return dashCount == 3;
+  auto it = anchors_.find( anchor );
+  return ( it == anchors_.end() ) ? nullptr : &it->second;
+}
+
+void Yaml::Detail::AnchorRecorder::Clear()
+{
+  events_.clear();
+  text_.clear();
+  recordings_.clear();
+  while( !anchors_.empty() )
+    spareAnchors_.push_back( anchors_.extract( anchors_.begin() ) );
+  isPending_ = false;
+}
+
+// Reuses the nodes of previous documents' anchors, so a parser reset for each
+// of many small documents doesn't allocate
+void Yaml::Detail::AnchorRecorder::SetAnchor( std::string_view anchor, Range range )
+{
+  if( spareAnchors_.empty() )
+  {
+    anchors_.insert_or_assign( std::string( anchor ), range );
+    return;
+  }
+  auto node = std::move( spareAnchors_.back() );
+  spareAnchors_.pop_back();
+  node.key().assign( anchor );
+  node.mapped() = range;
+  auto result = anchors_.insert( std::move( node ) );
+  if( !result.inserted ) // redefined anchor
+  {
+    result.position->second = range;
+    spareAnchors_.push_back( std::move( result.node ) );
+  }
+}
+
+bool Yaml::Detail::IsDocumentMarker( const char* curr, const char* end )
+{
+  constexpr std::ptrdiff_t kMarkerSize = 3;
+  if( end - curr < kMarkerSize || ( *curr != '-' && *curr != '.' ) )
+    return false;
+  if( curr[ 1 ] != *curr || curr[ 2 ] != *curr )
+    return false;
+  return ( end - curr == kMarkerSize ) || IsCharClass( curr[ kMarkerSize ], kWhiteClass );
 }
 
-void YamlParser::SkipSpaces()
+bool Yaml::Detail::IsContentLine( const char* curr, const char* end )
 {
-  for( ++curr_; curr_ < end_ && *curr_ == ' '; ++curr_, ++col_ )
+  for( ; curr < end && *curr == ' '; ++curr )
     ;
-  --curr_;
-  --col_;
+  return ( curr < end ) && !IsCharClass( *curr, kIgnoreLineClass ) && ( *curr != '%' );
 }
 
-void YamlParser::SkipLine()
+// Document markers are found with a line scan
+std::vector<DocumentText> Yaml::Detail::SplitDocuments( std::string_view yaml )
 {
-  constexpr std::array kEndLine = { '\r', '\n' };
-  for( ; curr_ < end_; ++curr_ )
+  std::vector<DocumentText> docs;
+  const char* end = yaml.data() + yaml.size();
+  const char* docStart = yaml.data();
+  size_t docLine = 1u;
+  bool hasContent = false;
+  size_t line = 1u;
+  for( const char* curr = yaml.data(); curr < end; ++line )
   {
-    if( CharIsIn( *curr_, kEndLine ) )
+    const char* lineEnd = std::find( curr, end, '\n' );
+    const char* nextLine = ( lineEnd < end ) ? lineEnd + 1 : end;
+    if( IsDocumentMarker( curr, end ) )
     {
-      --curr_;
-      break;
+      bool isStart = ( *curr == '-' );
+      const char* splitAt = isStart ? curr : nextLine;
+      if( hasContent )
+      {
+        docs.push_back( { std::string_view( docStart, splitAt ), docLine } );
+        docStart = splitAt;
+        docLine = isStart ? line : line + 1;
+      }
+      hasContent = false;
+    }
+    else if( IsContentLine( curr, end ) )
+    {
+      hasContent = true;
     }
+    curr = nextLine;
   }
+
+  // Trailing text without content belongs to the last document
+  if( hasContent || docs.empty() )
+    docs.push_back( { std::string_view( docStart, end ), docLine } );
+  else
+    docs.back().text = std::string_view( docs.back().text.data(), end );
+  return docs;
 }
 
-void YamlParser::HandleMissingNull()
+std::vector<DocumentText> Yaml::Detail::SplitTopLevel( std::string_view yaml, size_t pieceCount,
+                                                       bool& isSequence )
 {
-  if( !completeKeyValuePair_ )
+  std::vector<DocumentText> pieces;
+  const char* end = yaml.data() + yaml.size();
+  auto isEntry = []( const char* curr, const char* end )
+  {
+    return ( *curr == '-' ) && ( curr + 1 == end || IsCharClass( curr[ 1 ], kWhiteClass ) );
+  };
+
+  // Markers would start documents with their own state
+  for( std::string_view marker : { "---", "..." } )
+  {
+    for( auto pos = yaml.find( marker ); pos != std::string_view::npos; pos = yaml.find( marker, pos + 1 ) )
+    {
+      if( ( pos == 0 || yaml[ pos - 1 ] == '\n' ) && IsDocumentMarker( yaml.data() + pos, end ) )
+        return { { yaml, 1u } };
+    }
+  }
+
+  // The first content line determines the kind of top-level collection
+  const char* curr = yaml.data();
+  while( curr < end && !IsContentLine( curr, end ) )
   {
-    yamlHandler_.onScalar( "null" );
-    completeKeyValuePair_ = true;
+    curr = std::find( curr, end, '\n' );
+    curr += ( curr < end );
   }
-}
+  if( curr >= end || *curr == ' ' )
+    return { { yaml, 1u } };
+  isSequence = isEntry( curr, end );
 
-bool YamlParser::IsNormalChar() const
-{
-  // Colons and commas are only special YAML characters when they are 
-  // followed by a space. If not, then treat them as part of the token
-  constexpr std::array kIsWhite = { ' ', '\r', '\n', '\0' };
-  switch( *curr_ )
+  // Lines that start a top-level key or entry
+  auto isSplitLine = [&]( const char* line )
   {
-  case ':':
-  case ',':
-    if( !CharIsIn( PeekNext(), kIsWhite ) )
-      return true;
-    [[fallthrough]];
-  default:
-    return false;
+    if( isSequence )
+      return isEntry( line, end );
+    switch( *line )
+    {
+    case ' ': case '\t': case '\r': case '\n': case '#': case '%':
+    case '[': case ']': case '{': case '}': case ',': case '?': case ':': case '|': case '>':
+      return false;
+    default:
+      return !isEntry( line, end );
+    }
+  };
+
+  const char* pieceStart = yaml.data();
+  size_t pieceLine = 1u;
+  size_t pieceSize = yaml.size() / std::max( pieceCount, size_t( 1 ) );
+  for( size_t i = 1; i < pieceCount; ++i )
+  {
+    const char* splitAt = std::max( yaml.data() + i * pieceSize, pieceStart + 1 );
+    for( splitAt = std::find( splitAt, end, '\n' ); splitAt < end; splitAt = std::find( splitAt, end, '\n' ) )
+    {
+      if( ++splitAt < end && isSplitLine( splitAt ) )
+        break;
+    }
+    if( splitAt >= end )
+      break;
+    pieces.push_back( { std::string_view( pieceStart, static_cast<size_t>( splitAt - pieceStart ) ), pieceLine } );
+    pieceLine += static_cast<size_t>( std::count( pieceStart, splitAt, '\n' ) );
+    pieceStart = splitAt;
   }
+  pieces.push_back( { std::string_view( pieceStart, static_cast<size_t>( end - pieceStart ) ), pieceLine } );
+  return pieces;
 }
 
-bool YamlParser::ParseNode()
+void Yaml::Detail::ChunkRecorder::Add( EventType type, std::string_view str, YamlScalarStyle style )
 {
-  switch( *curr_ )
+  Event event;
+  event.type = type;
+  event.style = style;
+  event.textSize = str.size();
+  event.pos = static_cast<size_t>( *curr_ - source_.data() );
+  event.line = *line_;
+  event.lineStart = *lineStart_;
+  if( str.data() >= source_.data() && str.data() + str.size() <= source_.data() + source_.size() )
+  {
+    event.textPos = static_cast<size_t>( str.data() - source_.data() );
+  }
+  else
   {
-  case '\'': return ParseQuoted( '\'' );
-  case '\"': return ParseQuoted( '\"' );
-  default:   return ParsePlain();
+    event.isCopied = true;
+    event.textPos = text_.size();
+    text_ += str;
   }
+  events_.push_back( event );
 }
 
-bool YamlParser::ParsePlain() // Unquoted scalar
+///////////////////////////////////////////////////////////////////////////////
+
+Yaml::TypedScalar Yaml::DecodeScalar( std::string_view scalar )
 {
-  // Note: order is important; check for comma first
-  constexpr std::array kEndScalar = { ',', ':', '\t', '\r', '\n', ']', '}', '#' };
-  auto startStr = curr_;
-  for( ; curr_ < end_; ++curr_ ) // find end of scalar
+  TypedScalar typed; // string unless proven otherwise
+  if( scalar.empty() )
   {
-    if( CharIsIn( *curr_, kEndScalar ) ) // potential end
-    {
-      if( IsNormalChar() )
-        continue;
+    typed.type = ScalarType::Null;
+    return typed;
+  }
 
-      std::string_view str = ExtractStr( startStr, curr_, TrimTrailingBlanks::Yes );
-      col_ += curr_ - startStr;
-      return OutputScalar( str );
+  // The first character rules out most types
+  switch( scalar.front() )
+  {
+  case '~':
+  case 'n':
+  case 'N':
+    if( scalar == "~" || scalar == "null" || scalar == "Null" || scalar == "NULL" )
+      typed.type = ScalarType::Null;
+    break;
+  case 't':
+  case 'T':
+    if( scalar == "true" || scalar == "True" || scalar == "TRUE" )
+    {
+      typed.type = ScalarType::Bool;
+      typed.boolValue = true;
     }
+    break;
+  case 'f':
+  case 'F':
+    if( scalar == "false" || scalar == "False" || scalar == "FALSE" )
+      typed.type = ScalarType::Bool;
+    break;
+  case '0': case '1': case '2': case '3': case '4':
+  case '5': case '6': case '7': case '8': case '9':
+  case '-':
+  case '+':
+  case '.':
+    DecodeNumber( scalar, typed );
+    break;
+  default:
+    break;
   }
-  // End of the file
-  completeKeyValuePair_ = true;
-  return yamlHandler_.onScalar( ExtractStr( startStr, curr_, TrimTrailingBlanks::Yes ) );
+  return typed;
 }
 
-bool YamlParser::ParseQuoted(char quote)
+///////////////////////////////////////////////////////////////////////////////
+
+bool Yaml::DecodeBinary( std::string_view text, TaggedValue& value )
 {
-  constexpr auto kQuoteChars = 2;
+  // Sextet for each base64 character; kNotBase64 for anything else
+  static constexpr uint8_t kNotBase64 = 0xFF;
+  constexpr auto kSextets = []()
+  {
+    std::array<uint8_t, kAsciiTableSize> sextets{};
+    sextets.fill( kNotBase64 );
+    constexpr std::string_view kAlphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for( size_t i = 0u; i < kAlphabet.size(); ++i )
+      sextets[ static_cast<uint8_t>( kAlphabet[ i ] ) ] = static_cast<uint8_t>( i );
+    return sextets;
+  }();
 
-  // skip starting quote
-  auto startStr = ++curr_;
-  for( ; curr_ < end_; ++curr_ ) // find end of scalar
+  uint32_t bits = 0u;
+  size_t sextetCount = 0u;
+  size_t padCount = 0u;
+  for( char c : text )
   {
-    if ( *curr_ == quote ) // found the end
+    if( IsCharClass( c, kWhiteClass ) )
+      continue;
+    if( c == '=' )
     {
-      std::string_view str = ExtractStr( startStr, curr_, TrimTrailingBlanks::No );
-
-      // Skip to next important character to know if this is a key or value
-      static constexpr std::array kImportantChar = { ':', '\t', '\r', '\n', ',', ']', '}', '#' };
-      for( ++curr_; curr_ < end_; ++curr_ )
-        if( CharIsIn( *curr_, kImportantChar ) )
-          break;
-
-      col_ += curr_ - startStr + kQuoteChars;
-      return OutputScalar( str );
+      ++padCount;
+      continue;
+    }
+    auto sextet = kSextets[ static_cast<uint8_t>( c ) ];
+    if( sextet == kNotBase64 || padCount != 0 ) // nothing may follow padding
+      return false;
+    bits = ( bits << 6 ) | sextet;
+    if( ++sextetCount % 4 == 0 )
+    {
+      value.bytes.push_back( static_cast<char>( bits >> 16 ) );
+      value.bytes.push_back( static_cast<char>( bits >> 8 ) );
+      value.bytes.push_back( static_cast<char>( bits ) );
+      bits = 0u;
     }
   }
-  // End of the YAML but still inside unterminated quoted string
-  // Print out the first few characters of the quoted scalar
-  std::string errMessage( "Unterminated quoted scalar <" );
-  auto endStr = std::min( curr_, startStr + kMaxScalarStringPrefixForErrorMsg );
-  std::string_view str = ExtractStr( startStr-1, endStr, TrimTrailingBlanks::No );
-  errMessage += str;
-  errMessage += "...>";
-  return Error( errMessage );
+
+  // The final group has two or three characters, padded to four
+  switch( sextetCount % 4 )
+  {
+  case 0:
+    return padCount == 0;
+  case 2:
+    value.bytes.push_back( static_cast<char>( bits >> 4 ) );
+    return padCount == 2;
+  case 3:
+    value.bytes.push_back( static_cast<char>( bits >> 10 ) );
+    value.bytes.push_back( static_cast<char>( bits >> 2 ) );
+    return padCount == 1;
+  default:
+    return false;
+  }
 }
 
-bool YamlParser::OutputScalar( std::string_view str )
+bool Yaml::DecodeTimestamp( std::string_view text, TaggedValue& value )
 {
-  // Caller must evaluate the current character, hence --
-  if( *curr_-- == ':' ) // key
+  // Parses an unsigned number of minDigits to maxDigits digits
+  auto curr = text.data();
+  auto end = text.data() + text.size();
+  auto parseNumber = [&]( int& number, ptrdiff_t minDigits, ptrdiff_t maxDigits )
   {
-    HandleMissingNull(); // handle any imcomplete key/value pairs where there's no value
-    completeKeyValuePair_ = false;
-    return yamlHandler_.onKey( str );
-  }
-  // else value
-  completeKeyValuePair_ = true;
-  return yamlHandler_.onScalar( str );
+    if( curr == end || *curr < '0' || *curr > '9' ) // from_chars accepts a sign
+      return false;
+    auto digitsEnd = ( end - curr < maxDigits ) ? end : curr + maxDigits;
+    auto [ ptr, ec ] = std::from_chars( curr, digitsEnd, number );
+    if( ec != std::errc() || ptr - curr < minDigits )
+      return false;
+    curr = ptr;
+    return true;
+  };
+  auto isNext = [&]( char c )
+  {
+    if( curr == end || *curr != c )
+      return false;
+    ++curr;
+    return true;
+  };
+
+  int year = 0, month = 0, day = 0;
+  if( !parseNumber( year, 4, 4 ) || !isNext( '-' ) || !parseNumber( month, 1, 2 ) ||
+      !isNext( '-' ) || !parseNumber( day, 1, 2 ) )
+    return false;
+  std::chrono::year_month_day date{ std::chrono::year( year ), std::chrono::month( static_cast<unsigned>( month ) ),
+                                    std::chrono::day( static_cast<unsigned>( day ) ) };
+  if( !date.ok() )
+    return false;
+  using namespace std::chrono;
+  if( curr == end ) // date alone
+  {
+    value.time = sys_days( date );
+    value.isDate = true;
+    return true;
+  }
+
+  // Time, separated by 'T' or white space, with optional fraction and zone
+  if( !isNext( 'T' ) && !isNext( 't' ) )
+  {
+    if( !isNext( ' ' ) && !isNext( '\t' ) )
+      return false;
+    while( isNext( ' ' ) || isNext( '\t' ) )
+      ;
+  }
+  int hour = 0, minute = 0, second = 0;
+  if( !parseNumber( hour, 1, 2 ) || !isNext( ':' ) || !parseNumber( minute, 2, 2 ) ||
+      !isNext( ':' ) || !parseNumber( second, 2, 2 ) || hour > 23 || minute > 59 || second > 59 )
+    return false;
+  nanoseconds fraction{ 0 };
+  if( isNext( '.' ) )
+  {
+    if( curr == end || *curr < '0' || *curr > '9' )
+      return false;
+    int64_t digitValue = 1'000'000'000;
+    for( ; curr < end && *curr >= '0' && *curr <= '9'; ++curr ) // digits beyond nanoseconds are dropped
+    {
+      digitValue /= 10;
+      fraction += nanoseconds( ( *curr - '0' ) * digitValue );
+    }
+  }
+  while( isNext( ' ' ) || isNext( '\t' ) )
+    ;
+  int offsetMinutes = 0; // east of UTC
+  if( curr < end && ( *curr == '+' || *curr == '-' ) )
+  {
+    bool isWest = ( *curr++ == '-' );
+    int offsetHours = 0, offsetMins = 0;
+    if( !parseNumber( offsetHours, 1, 2 ) || ( isNext( ':' ) && !parseNumber( offsetMins, 2, 2 ) ) )
+      return false;
+    offsetMinutes = ( offsetHours * 60 + offsetMins ) * ( isWest ? -1 : 1 );
+  }
+  else
+  {
+    isNext( 'Z' ); // also UTC if omitted
+  }
+  if( curr != end )
+    return false;
+
+  value.time = sys_days( date ) + hours( hour ) + minutes( minute - offsetMinutes ) + seconds( second ) + fraction;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+YamlTagRegistry::YamlTagRegistry()
+{
+  Add( std::string( Yaml::kCoreTagPrefix ) + "binary", Yaml::DecodeBinary );
+  Add( std::string( Yaml::kCoreTagPrefix ) + "timestamp", Yaml::DecodeTimestamp );
+}
+
+void YamlTagRegistry::Add( std::string_view tag, Decoder decoder )
+{
+  decoders_.insert_or_assign( std::string( tag ), std::move( decoder ) );
+}
+
+void YamlTagRegistry::Remove( std::string_view tag )
+{
+  auto it = decoders_.find( tag );
+  if( it != decoders_.end() )
+    decoders_.erase( it );
+}
+
+const YamlTagRegistry::Decoder* YamlTagRegistry::Find( std::string_view tag ) const
+{
+  auto it = decoders_.find( tag );
+  return ( it == decoders_.end() ) ? nullptr : &it->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Yaml::Special Yaml::GetSpecialChars( std::string_view scalar )
+{
+  if( scalar.empty() )
+    return Yaml::Special(false);
+
+  // If already quoted, ignore
+  if( ( scalar.size() > 2 ) &&
+      ( scalar.front() == '\'' || scalar.front() == '\"' ) &&
+      ( scalar.front() == scalar.back() ) )
+    return Yaml::Special(false);
+
+  size_t specialPos = FindFirstSpecial( scalar );
+  if( specialPos == kInvalidPos ) // no special characters
+    return Yaml::Special(false);
+
+  // Quotes are themselves special, so neither kind can appear before specialPos
+  Yaml::Special special;
+  special.firstSpecialPos = specialPos;
+  special.firstSingleQuote = scalar.find( '\'', specialPos );
+  special.firstDoubleQuote = scalar.find( '\"', specialPos );
+  special.hasSpecialChars = true;
+  special.specialChar = scalar[ specialPos ];
+  return special;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Returns the quote character required to embed the scalar in a YAML file,
+// or '\0' if it can be embedded as is
+
+char Yaml::GetSafeQuote( std::string_view scalar )
+{
+  Yaml::Special special = GetSpecialChars( scalar );
+  if( !special.hasSpecialChars )
+    return '\0';
+
+  // Ensure scalar doesn't have quotes of two different types
+  assert( !( special.firstDoubleQuote < kInvalidPos &&
+             special.firstSingleQuote < kInvalidPos ) );
+
+  // Default to single character quote
+  return ( special.firstSingleQuote < kInvalidPos ) ? '\"' : '\'';
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Guarantees the result can be embedded in a YAML file; adding quotes if needed
+
+std::string Yaml::CreateSafeScalar( std::string_view scalar )
+{
+  constexpr size_t kQuoteChars = 2;
+  std::string yaml;
+  yaml.reserve( scalar.size() + kQuoteChars );
+  YamlWriter( std::back_inserter( yaml ) ).SafeScalar( scalar );
+  return yaml;
+}
+
+std::string Yaml::CreateKeyValue( std::string_view tag, std::string_view scalar )
+{
+  constexpr size_t kExtraChars = 5; // ": ", quotes and newline
+  std::string yaml;
+  yaml.reserve( tag.size() + scalar.size() + kExtraChars );
+  YamlWriter( std::back_inserter( yaml ) ).KeyValue( tag, scalar );
+  return yaml;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+YamlFile::YamlFile( const std::filesystem::path& path )
+{
+#if defined( _WIN32 )
+  HANDLE file = CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+  if( file == INVALID_HANDLE_VALUE )
+    return;
+  LARGE_INTEGER fileSize{};
+  if( !GetFileSizeEx( file, &fileSize ) )
+  {
+    // leave unopened
+  }
+  else if( fileSize.QuadPart == 0 )
+  {
+    isOpen_ = true; // empty files can't be mapped
+  }
+  else
+  {
+    HANDLE mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if( mapping != nullptr )
+    {
+      // The view keeps the mapping alive after its handle is closed
+      data_ = static_cast<const char*>( MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+      size_ = static_cast<size_t>( fileSize.QuadPart );
+      isOpen_ = ( data_ != nullptr );
+      CloseHandle( mapping );
+    }
+  }
+  CloseHandle( file );
+#else
+  int file = open( path.c_str(), O_RDONLY );
+  if( file < 0 )
+    return;
+  struct stat fileStat{};
+  if( fstat( file, &fileStat ) != 0 )
+  {
+    // leave unopened
+  }
+  else if( fileStat.st_size == 0 )
+  {
+    isOpen_ = true; // empty files can't be mapped
+  }
+  else
+  {
+    // The mapping remains valid after the file is closed
+    void* data = mmap( nullptr, static_cast<size_t>( fileStat.st_size ), PROT_READ, MAP_PRIVATE, file, 0 );
+    if( data != MAP_FAILED )
+    {
+      madvise( data, static_cast<size_t>( fileStat.st_size ), MADV_SEQUENTIAL ); // parser reads front to back
+      data_ = static_cast<const char*>( data );
+      size_ = static_cast<size_t>( fileStat.st_size );
+      isOpen_ = true;
+    }
+  }
+  close( file );
+#endif
+}
+
+YamlFile::~YamlFile()
+{
+  if( data_ == nullptr )
+    return;
+#if defined( _WIN32 )
+  UnmapViewOfFile( data_ );
+#else
+  munmap( const_cast<char*>( data_ ), size_ );
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+template class PKIsensee::BasicYamlParser<YamlHandler>;
+
+///////////////////////////////////////////////////////////////////////////////
+
+YamlStreamParser::YamlStreamParser( YamlHandler& handler ) :
+  yamlParser_( std::string_view( "" ), handler )
+{
+}
+
+bool YamlStreamParser::Feed( std::string_view yaml )
+{
+  if( isStopped_ )
+    return false;
+  StartDocument();
+
+  // Only parse complete lines; any partial line is kept for the next chunk
+  auto lastLineEnd = yaml.rfind( '\n' );
+  buffer_ += yaml;
+  if( lastLineEnd == std::string_view::npos )
+    return true;
+  size_t endPos = buffer_.size() - yaml.size() + lastLineEnd + 1;
+  return ParseBuffered( endPos, false );
+}
+
+bool YamlStreamParser::Finish()
+{
+  if( isStopped_ )
+    return false;
+  StartDocument();
+  if( !ParseBuffered( buffer_.size(), true ) )
+    return false;
+  if( yamlParser_.isDocumentOpen_ )
+    yamlParser_.EndDocument();
+  isStopped_ = true; // the document is complete
+  return true;
+}
+
+void YamlStreamParser::StartDocument()
+{
+  if( isStarted_ )
+    return;
+  yamlParser_.StartDocument();
+  isStarted_ = true;
+}
+
+bool YamlStreamParser::ParseBuffered( size_t endPos, bool isFinalText )
+{
+  yamlParser_.begin_ = buffer_.data();
+  yamlParser_.curr_ = buffer_.data();
+  yamlParser_.end_ = buffer_.data() + endPos;
+  yamlParser_.baseOffset_ = consumed_;
+  yamlParser_.isFinalText_ = isFinalText;
+  yamlParser_.isSuspended_ = false;
+  if( !yamlParser_.ParseText() && !yamlParser_.isSuspended_ )
+  {
+    isStopped_ = true;
+    return false;
+  }
+
+  // Discard the parsed text; a suspended token is reparsed from its start
+  auto consumed = std::min( static_cast<size_t>( yamlParser_.curr_ - buffer_.data() ), endPos );
+  buffer_.erase( 0, consumed );
+  consumed_ += consumed;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+YamlReader::YamlReader( std::string_view yaml ) :
+  yamlParser_( yaml, events_ )
+{
+  events_.reader_ = this;
+}
+
+bool YamlReader::Next( YamlEvent& event )
+{
+  isAtKey_ = false;
+  // Parse until at least one event is available
+  while( !events_.Pop( event ) )
+  {
+    if( isDone_ )
+      return false;
+    if( !isStarted_ )
+    {
+      yamlParser_.StartDocument();
+      isStarted_ = true;
+    }
+    else if( yamlParser_.curr_ < yamlParser_.end_ )
+    {
+      isDone_ = !yamlParser_.ParseStep(); // stops on error
+    }
+    else
+    {
+      if( yamlParser_.isDocumentOpen_ )
+        yamlParser_.EndDocument();
+      isDone_ = true;
+    }
+  }
+  isAtKey_ = ( event.type == YamlEvent::Type::Key );
+  return true;
+}
+
+bool YamlReader::Skip()
+{
+  if( !isAtKey_ )
+    return false;
+  isAtKey_ = false;
+
+  // Keys replayed from an anchor are queued along with their values
+  if( events_.SkipValue() )
+    return true;
+
+  // Otherwise the key was the last event of its parsing step, leaving the
+  // parser on the following ':'
+  yamlParser_.SkipValue();
+  ++yamlParser_.curr_;
+  return true;
+}
+
+void YamlReader::EventQueue::onErrorCode( const YamlError& error )
+{
+  // The message is formatted within the error, so keep a copy
+  errMessage_ = error.GetText();
+  YamlEvent event{ YamlEvent::Type::Error, errMessage_, YamlScalarStyle::Plain, error.line, error.col, error.offset };
+  events_.push_back( event );
+}
+
+void YamlReader::EventQueue::Add( YamlEvent::Type type, std::string_view str, YamlScalarStyle style )
+{
+  assert( reader_ != nullptr );
+  const auto& yamlParser = reader_->yamlParser_;
+  YamlEvent event{ type, str, style, yamlParser.GetLine(), yamlParser.GetCol(), yamlParser.GetOffset() };
+  events_.push_back( event );
+}
+
+bool YamlReader::EventQueue::Pop( YamlEvent& event )
+{
+  if( next_ == events_.size() )
+  {
+    events_.clear();
+    next_ = 0u;
+    return false;
+  }
+  event = events_[ next_++ ];
+  return true;
+}
+
+// Drops the queued events of the value following the key just popped. False
+// if none are queued. An error within the value is kept.
+bool YamlReader::EventQueue::SkipValue()
+{
+  if( next_ == events_.size() )
+    return false;
+  size_t depth = 0u;
+  do
+  {
+    switch( events_[ next_ ].type )
+    {
+    case YamlEvent::Type::StartSequence:
+    case YamlEvent::Type::StartMapping:
+      ++depth;
+      break;
+    case YamlEvent::Type::EndSequence:
+    case YamlEvent::Type::EndMapping:
+      --depth;
+      break;
+    case YamlEvent::Type::Error:
+      return true;
+    default:
+      break;
+    }
+    ++next_;
+  } while( depth != 0 && next_ < events_.size() );
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool YamlQuery::AddPath( std::string_view pathText )
+{
+  Path path;
+  const char* curr = pathText.data();
+  const char* end = curr + pathText.size();
+  while( curr < end )
+  {
+    if( *curr == '[' ) // index
+    {
+      PathStep step;
+      auto [ ptr, ec ] = std::from_chars( curr + 1, end, step.index );
+      if( ec != std::errc() || ptr == end || *ptr != ']' || step.index == kNoIndex )
+        return false;
+      path.push_back( step );
+      curr = ptr + 1;
+    }
+    else // key
+    {
+      if( !path.empty() && *curr++ != '.' )
+        return false;
+      auto keyEnd = std::find_if( curr, end, []( char c ) { return c == '.' || c == '['; } );
+      if( keyEnd == curr )
+        return false;
+      path.push_back( { std::string( curr, keyEnd ) } );
+      curr = keyEnd;
+    }
+  }
+  if( path.empty() )
+    return false;
+  paths_.push_back( std::move( path ) );
+  values_.emplace_back();
+  return true;
+}
+
+bool YamlQuery::Run( std::string_view yaml )
+{
+  std::fill( values_.begin(), values_.end(), std::nullopt );
+  foundCount_ = 0u;
+  if( paths_.empty() )
+    return true;
+
+  decodedValues_.resize( paths_.size() );
+  Matcher matcher( *this, yaml );
+  BasicYamlParser<Matcher> yamlParser( yaml, matcher );
+  yamlParser.Parse(); // stops early once all paths are found
+  return !matcher.HasError();
+}
+
+std::optional<std::string_view> YamlQuery::GetValue( size_t pathIndex ) const
+{
+  assert( pathIndex < values_.size() );
+  return values_[ pathIndex ];
+}
+
+YamlKeyAction YamlQuery::Matcher::onKey( std::string_view key )
+{
+  if( isDone_ )
+    return YamlKeyAction::Stop;
+  if( frames_.empty() ) // the root mapping isn't reported by the parser
+  {
+    StartCollection( false );
+  }
+  else if( frames_.back().isSequence ) // nor are the mappings of block sequence entries
+  {
+    StartCollection( false );
+    frames_.back().isEntry = true;
+  }
+  auto& frame = frames_.back();
+  frame.key = key;
+  frame.hasKey = true;
+
+  for( size_t i = 0; i < query_.paths_.size(); ++i )
+  {
+    if( !query_.values_[ i ] && IsMatch( query_.paths_[ i ], true ) )
+      return YamlKeyAction::Continue;
+  }
+  frame.hasKey = false;
+  return YamlKeyAction::Skip;
+}
+
+bool YamlQuery::Matcher::onScalar( std::string_view scalar )
+{
+  if( isDone_ )
+    return false;
+  for( size_t i = 0; i < query_.paths_.size(); ++i )
+  {
+    if( !query_.values_[ i ] && IsMatch( query_.paths_[ i ], false ) )
+    {
+      query_.values_[ i ] = scalar;
+      if( scalar.data() < yaml_.data() || scalar.data() >= yaml_.data() + yaml_.size() )
+      {
+        query_.decodedValues_[ i ] = scalar;
+        query_.values_[ i ] = query_.decodedValues_[ i ];
+      }
+      ++query_.foundCount_;
+    }
+  }
+  EndValue();
+  return query_.foundCount_ < query_.paths_.size();
+}
+
+void YamlQuery::Matcher::onEndSequence()
+{
+  if( !frames_.empty() && frames_.back().isEntry )
+    EndCollection();
+  EndCollection();
+}
+
+// A new entry ends the mapping of the previous one
+void YamlQuery::Matcher::onSequenceEntry()
+{
+  if( !frames_.empty() && frames_.back().isEntry )
+    EndCollection();
+}
+
+void YamlQuery::Matcher::StartCollection( bool isSequence )
+{
+  Frame frame;
+  frame.isSequence = isSequence;
+  frames_.push_back( frame );
+}
+
+void YamlQuery::Matcher::EndCollection()
+{
+  if( !frames_.empty() )
+    frames_.pop_back();
+  EndValue();
+}
+
+void YamlQuery::Matcher::EndValue()
+{
+  if( frames_.empty() )
+    return;
+  auto& frame = frames_.back();
+  if( frame.hasKey )
+    frame.hasKey = false;
+  else if( frame.isSequence )
+    ++frame.index;
+}
+
+// True if the current location matches path, or is a prefix of it
+bool YamlQuery::Matcher::IsMatch( const Path& path, bool isPrefix ) const
+{
+  if( isPrefix ? path.size() < frames_.size() : path.size() != frames_.size() )
+    return false;
+  for( size_t i = 0; i < frames_.size(); ++i )
+  {
+    const auto& frame = frames_[ i ];
+    const auto& step = path[ i ];
+    if( frame.hasKey )
+    {
+      if( step.index != kNoIndex || step.key != frame.key )
+        return false;
+    }
+    else if( !frame.isSequence || step.index != frame.index )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const YamlNode* YamlNode::Find( std::string_view findKey ) const
+{
+  auto kids = GetChildren();
+  auto it = std::find_if( kids.begin(), kids.end(), [&]( const YamlNode& n ) { return n.key == findKey; } );
+  return ( it == kids.end() ) ? nullptr : &*it;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* YamlDocument::Arena::Allocate( size_t bytes, size_t alignment )
+{
+  auto offset = ( alignment - reinterpret_cast<uintptr_t>( next_ ) % alignment ) % alignment;
+  if( next_ == nullptr || static_cast<size_t>( end_ - next_ ) < offset + bytes )
+  {
+    // Oversized requests get a block of their own
+    auto blockSize = std::max( kBlockSize, bytes + alignment );
+    blocks_.push_back( std::make_unique_for_overwrite<std::byte[]>( blockSize ) );
+    next_ = blocks_.back().get();
+    end_ = next_ + blockSize;
+    offset = ( alignment - reinterpret_cast<uintptr_t>( next_ ) % alignment ) % alignment;
+  }
+  void* result = next_ + offset;
+  next_ += offset + bytes;
+  return result;
+}
+
+void YamlDocument::Arena::Clear()
+{
+  blocks_.clear();
+  next_ = end_ = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Collects parser events into YamlNodes. Children of open collections are
+// gathered on a shared stack and copied into the arena as one contiguous
+// array when their collection ends. The parser reports the keys of block
+// sequence entries, e.g. "- key: value", directly in the sequence, so each
+// entry's mapping is opened here and closed by the next entry.
+
+class YamlDocument::Builder final : public YamlStaticHandler
+{
+public:
+
+  Builder( YamlDocument& doc, std::string_view yaml ) :
+    doc_( doc ),
+    yaml_( yaml )
+  {
+  }
+
+  void onStartDocument()
+  {
+    anchors_.clear(); // anchors are local to their document
+    anchor_.clear();
+    StartCollection( YamlNode::Type::Mapping );
+  }
+
+  void onEndDocument()
+  {
+    // Close anything left open, then the root itself
+    while( !open_.empty() )
+      EndCollection();
+    roots_.push_back( children_.back() );
+    children_.pop_back();
+  }
+
+  void onStartSequence()
+  {
+    StartCollection( YamlNode::Type::Sequence );
+  }
+
+  void onEndSequence()
+  {
+    EndEntry();
+    if( open_.size() > 1 ) // never close the root early
+      EndCollection();
+  }
+
+  void onSequenceEntry()
+  {
+    EndEntry();
+  }
+
+  void onStartMapping()
+  {
+    StartCollection( YamlNode::Type::Mapping );
+  }
+
+  void onEndMapping()
+  {
+    if( open_.size() > 1 )
+      EndCollection();
+  }
+
+  bool onKey( std::string_view key )
+  {
+    if( open_.back().node.type == YamlNode::Type::Sequence )
+    {
+      // An anchor here belongs to the key, not the entry's mapping
+      auto anchor = std::exchange( anchor_, {} );
+      StartCollection( YamlNode::Type::Mapping );
+      open_.back().isEntry = true;
+      anchor_ = std::move( anchor );
+    }
+    key_ = Intern( key );
+    if( !anchor_.empty() ) // anchored key, e.g. "&a key: value"
+    {
+      YamlNode node;
+      node.scalar = key_;
+      anchors_.insert_or_assign( std::exchange( anchor_, {} ), node );
+    }
+    return true;
+  }
+
+  bool onScalar( std::string_view scalar )
+  {
+    YamlNode node;
+    node.key = TakeKey();
+    node.scalar = Intern( scalar );
+    children_.push_back( node );
+    if( !anchor_.empty() )
+      AddAnchor( node );
+    return true;
+  }
+
+  // Aliases share the anchored node rather than copying it
+  void onAnchor( std::string_view anchor )
+  {
+    anchor_ = anchor;
+  }
+
+  bool onAlias( std::string_view alias )
+  {
+    auto it = anchors_.find( alias );
+    if( it == anchors_.end() )
+      return false;
+    YamlNode node = it->second;
+    node.key = TakeKey();
+    children_.push_back( node );
+    return true;
+  }
+
+  void onError( std::string_view errMessage, size_t line, size_t col )
+  {
+    doc_.error_ = errMessage;
+    doc_.errorLine_ = line;
+    doc_.errorCol_ = col;
+  }
+
+  std::span<const YamlNode> GetRoots()
+  {
+    return CopyToArena( roots_ );
+  }
+
+private:
+
+  struct OpenCollection
+  {
+    YamlNode node;
+    size_t firstChild = 0u; // index of the first child in children_
+    std::string anchor;
+    bool isEntry = false;   // mapping of a block sequence entry
+  };
+
+  void StartCollection( YamlNode::Type type )
+  {
+    OpenCollection open;
+    open.node.type = type;
+    open.node.key = TakeKey();
+    open.firstChild = children_.size();
+    open.anchor = std::exchange( anchor_, {} );
+    open_.push_back( std::move( open ) );
+  }
+
+  void EndCollection()
+  {
+    if( !anchor_.empty() ) // the anchored node is missing, e.g. "[ &a ]"
+    {
+      YamlNode node;
+      node.scalar = Intern( "null" );
+      AddAnchor( node );
+    }
+    OpenCollection open = std::move( open_.back() );
+    open_.pop_back();
+    auto kids = CopyToArena( std::span<const YamlNode>( children_ ).subspan( open.firstChild ) );
+    open.node.children = kids.data();
+    open.node.childCount = kids.size();
+    children_.resize( open.firstChild );
+    children_.push_back( open.node );
+    if( !open.anchor.empty() )
+    {
+      anchor_ = std::move( open.anchor );
+      AddAnchor( open.node );
+    }
+  }
+
+  void EndEntry()
+  {
+    if( open_.back().isEntry )
+      EndCollection();
+  }
+
+  void AddAnchor( YamlNode node )
+  {
+    node.key = {}; // an alias supplies its own key
+    anchors_.insert_or_assign( std::exchange( anchor_, {} ), node );
+  }
+
+  std::span<const YamlNode> CopyToArena( std::span<const YamlNode> nodes )
+  {
+    if( nodes.empty() )
+      return {};
+    auto* copy = doc_.arena_.Allocate<YamlNode>( nodes.size() );
+    std::uninitialized_copy( nodes.begin(), nodes.end(), copy );
+    return std::span<const YamlNode>( copy, nodes.size() );
+  }
+
+  std::string_view TakeKey()
+  {
+    return std::exchange( key_, std::string_view{} );
+  }
+
+  // Strings within the source text are referenced as is; anything else
+  // (e.g. decoded by the parser) is copied into the arena
+  std::string_view Intern( std::string_view str )
+  {
+    if( str.data() >= yaml_.data() && str.data() + str.size() <= yaml_.data() + yaml_.size() )
+      return str;
+    auto* copy = doc_.arena_.Allocate<char>( str.size() );
+    std::copy( str.begin(), str.end(), copy );
+    return std::string_view( copy, str.size() );
+  }
+
+private:
+
+  YamlDocument&               doc_;
+  std::string_view            yaml_;
+  std::vector<OpenCollection> open_;
+  std::vector<YamlNode>       children_; // children of all open collections
+  std::vector<YamlNode>       roots_;
+  std::string_view            key_;      // key awaiting its value
+  std::string                 anchor_;   // anchor awaiting its node
+  std::map<std::string, YamlNode, std::less<>> anchors_;
+
+}; // class YamlDocument::Builder
+
+bool YamlDocument::Parse( std::string_view yaml, size_t threadCount )
+{
+  Clear();
+  Builder builder( *this, yaml );
+  BasicYamlParser<Builder> yamlParser( yaml, builder );
+  bool isParsed = ( threadCount == 1 ) ? yamlParser.Parse() : yamlParser.ParseChunked( threadCount );
+  if( !isParsed )
+    return false;
+  documents_ = builder.GetRoots();
+  return true;
+}
+
+void YamlDocument::Clear()
+{
+  arena_.Clear();
+  documents_ = {};
+  error_.clear();
+  errorLine_ = errorCol_ = 0u;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
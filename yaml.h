@@ -15,16 +15,79 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include <stack>
-
-#include "Util.h"
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace PKIsensee
 {
 
+// Causes of parse errors
+enum class YamlErrorCode : uint8_t
+{
+  FileOpen,
+  Tab,
+  Unsupported,          // detail is the indicator
+  MaxDepth,
+  UnbalancedClose,
+  InvalidEscape,        // detail is the escape sequence
+  UnterminatedQuote,    // detail is the start of the scalar
+  BlockInFlow,
+  InvalidBlockHeader,
+  MissingAnchorName,
+  MissingAliasName,
+  AliasKey,
+  UnknownAlias,         // detail is the alias
+  AliasExpansion,
+  UnterminatedVerbatimTag,
+  NamedTagHandle,
+  InvalidTaggedScalar   // detail is the tag
+};
+
+// A parse error, reported without allocating. detail refers to parser or
+// source text, so is only valid during onError. GetText() formats the message
+// on demand into a fixed buffer within the error, truncating long details; the
+// text is null-terminated.
+struct YamlError
+{
+  YamlErrorCode    code = YamlErrorCode::Tab;
+  size_t           offset = 0u; // bytes from the start of the text
+  size_t           line = 0u;
+  size_t           col = 0u;
+  std::string_view detail;
+
+  std::string_view GetText() const;
+
+private:
+
+  static constexpr size_t kMaxTextSize = 128u;
+  mutable std::array<char, kMaxTextSize> text_;
+};
+
+namespace Yaml { struct TaggedValue; }
+
 struct YamlHandler
 {
   virtual ~YamlHandler() {}
@@ -36,23 +99,736 @@ struct YamlHandler
   virtual void onEndMapping() {}
   virtual bool onKey( std::string_view ) { return true; } // true to continue; false to stop
   virtual bool onScalar( std::string_view ) { return true; } // true to continue; false to stop
+
+  // A tag, e.g. "tag:yaml.org,2002:binary" for !!binary, before the events of
+  // its node; then, for scalars with a tag in the parser's YamlTagRegistry,
+  // the decoded value before onScalar
+  virtual void onTag( std::string_view ) {}
+  virtual void onTagged( std::string_view, const Yaml::TaggedValue& ) {}
   virtual void onError( std::string_view, [[maybe_unused]] size_t line, 
                                           [[maybe_unused]] size_t col ) {}
+
+  // Override to receive the error code and offset; forwards the formatted message
+  virtual void onErrorCode( const YamlError& error )
+  {
+    onError( error.GetText(), error.line, error.col );
+  }
+};
+
+// Handlers other than YamlHandler may return this from onKey rather than bool
+enum class YamlKeyAction
+{
+  Stop,     // stop parsing
+  Continue, // parse the value as usual
+  Skip      // skip the value, including nested collections, without events
+};
+
+template <typename Result>
+concept IsYamlKeyResult = std::convertible_to<Result, bool> || std::same_as<Result, YamlKeyAction>;
+
+// Handlers other than YamlHandler may take this as a second onScalar argument.
+// Only plain scalars are resolved to types like int or bool; quoted scalars
+// are always strings.
+enum class YamlScalarStyle : uint8_t
+{
+  Plain,
+  SingleQuoted,
+  DoubleQuoted,
+  Literal, // | block scalar
+  Folded   // > block scalar
+};
+
+template <typename Handler>
+concept IsYamlScalarHandler = 
+  requires( Handler& handler, std::string_view str )
+  {
+    { handler.onScalar( str ) } -> std::convertible_to<bool>;
+  } ||
+  requires( Handler& handler, std::string_view str, YamlScalarStyle style )
+  {
+    { handler.onScalar( str, style ) } -> std::convertible_to<bool>;
+  };
+
+// Any type with the YamlHandler callbacks can receive parser events. Types
+// other than YamlHandler are called directly rather than through a vtable,
+// which lets the compiler inline the callbacks. They may provide
+// onErrorCode( const YamlError& ) in place of onError, and onTag and onTagged
+// as YamlHandler does. They may also provide onAnchor( std::string_view ),
+// called before the events of the node with the anchor; onSequenceEntry(),
+// called at each "- " entry of a block sequence; and bool onAlias(
+// std::string_view ) to resolve aliases rather than have the anchored events
+// replayed, returning false for an unknown alias.
+template <typename Handler>
+concept IsYamlHandler = requires( Handler& handler, std::string_view str, size_t pos )
+{
+  handler.onStartDocument();
+  handler.onEndDocument();
+  handler.onStartSequence();
+  handler.onEndSequence();
+  handler.onStartMapping();
+  handler.onEndMapping();
+  { handler.onKey( str ) } -> IsYamlKeyResult;
+  requires IsYamlScalarHandler<Handler>;
+  requires requires { handler.onError( str, pos, pos ); } ||
+           requires( const YamlError& error ) { handler.onErrorCode( error ); };
+};
+
+// Non-virtual no-op callbacks; derive from this and hide only the callbacks
+// of interest to build a statically dispatched handler
+struct YamlStaticHandler
+{
+  void onStartDocument() {}
+  void onEndDocument() {}
+  void onStartSequence() {}
+  void onEndSequence() {}
+  void onStartMapping() {}
+  void onEndMapping() {}
+  bool onKey( std::string_view ) { return true; } // true to continue; false to stop
+  bool onScalar( std::string_view ) { return true; } // true to continue; false to stop
+  void onError( std::string_view, [[maybe_unused]] size_t line,
+                                  [[maybe_unused]] size_t col ) {}
+};
+
+namespace Yaml {
+
+// Tags of the YAML 1.2 core schema
+enum class ScalarType : uint8_t
+{
+  Null,
+  Bool,
+  Int,
+  Float,
+  String
+};
+
+struct TypedScalar
+{
+  ScalarType type = ScalarType::String;
+  bool       boolValue = false;
+  int64_t    intValue = 0;
+  double     floatValue = 0.0;
+};
+
+// Resolves a plain scalar using the YAML 1.2 core schema, e.g. "~" is null,
+// "0x1F" is 31 and ".inf" is infinity. Integers too large for int64_t are
+// floats, and floats too large for double are infinite; anything unrecognized
+// is a string.
+TypedScalar DecodeScalar( std::string_view );
+
+// "!!" is shorthand for this prefix, e.g. !!binary is tag:yaml.org,2002:binary
+constexpr std::string_view kCoreTagPrefix = "tag:yaml.org,2002:";
+
+// Value of a tagged scalar, filled in by a YamlTagRegistry decoder. Decoders
+// set the members that suit their tag; others may keep their results in the
+// state of the decoder instead.
+struct TaggedValue
+{
+  std::string bytes; // !!binary data, or text
+  std::chrono::sys_time<std::chrono::nanoseconds> time{}; // !!timestamp, in UTC
+  bool        isDate = false; // !!timestamp without a time of day
+};
+
+// Tag decoders for the YAML 1.1 types repository. DecodeBinary converts base64,
+// ignoring white space. DecodeTimestamp converts e.g. "2001-12-14 21:59:43.10 -5"
+// to UTC; a date alone is midnight UTC of that day.
+bool DecodeBinary( std::string_view, TaggedValue& );
+bool DecodeTimestamp( std::string_view, TaggedValue& );
+
+} // end namespace Yaml
+
+// Maps tags to functions that decode tagged scalars as they are parsed, so
+// values such as !!binary needn't be converted in a second pass over the
+// results. Handlers receive the values through onTagged, followed by the
+// scalar as written. Tags are matched after "!!" is expanded, and by default
+// include tag:yaml.org,2002:binary and tag:yaml.org,2002:timestamp.
+
+class YamlTagRegistry
+{
+public:
+
+  // Decodes the scalar text into value; false if the text isn't valid for the
+  // tag. Decoders are called from the parsing thread, which for ParseChunked is
+  // the thread delivering events.
+  using Decoder = std::function<bool( std::string_view text, Yaml::TaggedValue& value )>;
+
+  YamlTagRegistry();
+  YamlTagRegistry( const YamlTagRegistry& ) = delete;
+  YamlTagRegistry( YamlTagRegistry&& ) = delete;
+  YamlTagRegistry& operator=( const YamlTagRegistry& ) = delete;
+  YamlTagRegistry&& operator=( YamlTagRegistry&& ) = delete;
+
+  // Replaces any decoder already registered for the tag
+  void Add( std::string_view tag, Decoder );
+  void Remove( std::string_view tag );
+  const Decoder* Find( std::string_view tag ) const; // nullptr if not registered
+
+private:
+
+  std::map<std::string, Decoder, std::less<>> decoders_;
+};
+
+// Statically dispatched handler that receives plain scalars already converted
+// to their core schema type. Derive as struct MyHandler : YamlTypedHandler<MyHandler>
+// and hide the callbacks of interest. Quoted scalars and unrecognized plain
+// scalars arrive through onString.
+template <typename Derived>
+struct YamlTypedHandler : public YamlStaticHandler
+{
+  bool onNull() { return true; } // true to continue; false to stop
+  bool onBool( bool ) { return true; }
+  bool onInt( int64_t ) { return true; }
+  bool onDouble( double ) { return true; }
+  bool onString( std::string_view ) { return true; }
+
+  bool onScalar( std::string_view scalar, YamlScalarStyle style )
+  {
+    auto& derived = static_cast<Derived&>( *this );
+    if( style != YamlScalarStyle::Plain )
+      return derived.onString( scalar );
+    auto typed = Yaml::DecodeScalar( scalar );
+    switch( typed.type )
+    {
+    case Yaml::ScalarType::Null:  return derived.onNull();
+    case Yaml::ScalarType::Bool:  return derived.onBool( typed.boolValue );
+    case Yaml::ScalarType::Int:   return derived.onInt( typed.intValue );
+    case Yaml::ScalarType::Float: return derived.onDouble( typed.floatValue );
+    default:                      return derived.onString( scalar );
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parser internals shared by all BasicYamlParser instantiations
+
+namespace Yaml::Detail {
+
+constexpr size_t kAsciiTableSize = 256;
+constexpr size_t kNoLevel = size_t( -1 );
+constexpr size_t kMaxScalarStringPrefixForErrorMsg = 12; // leading chars to print on error
+
+enum class TrimTrailingBlanks
+{
+  No,
+  Yes
+};
+
+// Characters that potentially end a plain scalar
+constexpr std::array kEndScalar = { ',', ':', '\t', '\r', '\n', ']', '}', '#' };
+
+// Character classes used by the parser; a character may belong to several
+using CharClass = uint8_t;
+constexpr CharClass kEndScalarClass   = 0x01; // may end a plain scalar
+constexpr CharClass kIndentClass      = 0x02; // leading indentation
+constexpr CharClass kIgnoreLineClass  = 0x04; // line has no indentation-relevant content
+constexpr CharClass kEndLineClass     = 0x08; // line terminator
+constexpr CharClass kWhiteClass       = 0x10; // makes a preceding ':' or ',' significant
+constexpr CharClass kSpecialClass     = 0x20; // requires an emitted scalar to be quoted
+constexpr CharClass kSkipValueClass   = 0x40; // may end a skipped value
+constexpr CharClass kEndDoubleQuotedClass = 0x80; // ends or escapes double-quoted text
+
+// Any character less than ' ' (0x20) or greater than 'z' (0x7A) is unusual
+constexpr char kLowerBound = ' ';
+constexpr char kUpperBound = 'z';
+
+// Characters that end the text of a double-quoted scalar or start an escape
+constexpr std::array kEndDoubleQuoted = { '\"', '\\' };
+
+// Characters that can change where a skipped value ends
+constexpr std::array kSkipValue = { '\n', '[', ']', '{', '}', '\'', '\"', ',', '#', '|', '>' };
+
+// Characters in the 0x20 - 0x7A range are also special YAML values:
+constexpr std::array kSpecialChar = {
+  '!', '\"', '#', '$', '%', '&', '\'', '*', ',', '-', 
+  '/', ':', '<', '=', '>', '?', '@', '[', '\\', ']', '`'
+};
+
+// Maps each 8-bit character to the classes it belongs to; built at compile time
+inline constexpr auto kCharClasses = []()
+{
+  std::array<CharClass, kAsciiTableSize> charClasses{};
+  auto addClass = [&]( const auto& chars, CharClass charClass )
+  {
+    for( char c : chars )
+      charClasses[ static_cast<uint8_t>( c ) ] |= charClass;
+  };
+  addClass( kEndScalar, kEndScalarClass );
+  addClass( std::array{ ' ', '-' }, kIndentClass );
+  addClass( std::array{ '\r', '\n', '#' }, kIgnoreLineClass );
+  addClass( std::array{ '\r', '\n' }, kEndLineClass );
+  addClass( std::array{ ' ', '\r', '\n', '\0' }, kWhiteClass );
+  addClass( kSpecialChar, kSpecialClass );
+  addClass( kSkipValue, kSkipValueClass );
+  addClass( kEndDoubleQuoted, kEndDoubleQuotedClass );
+  for( size_t c = 0; c < kAsciiTableSize; ++c )
+  {
+    if( c < kLowerBound || c > kUpperBound )
+      charClasses[ c ] |= kSpecialClass;
+  }
+  return charClasses;
+}();
+
+inline bool IsCharClass( char c, CharClass charClass )
+{
+  // Treat as unsigned 8-bit to ensure characters with the high bit set map correctly
+  return ( kCharClasses[ static_cast<uint8_t>( c ) ] & charClass ) != 0;
+}
+
+inline std::string_view ExtractStr( const char* start, const char* end, TrimTrailingBlanks trimTrailingBlanks )
+{
+  assert( start != nullptr && end != nullptr );
+  assert( start <= end );
+  std::string_view str( start, static_cast<size_t>(end - start) );
+  if( trimTrailingBlanks == TrimTrailingBlanks::Yes )
+    str.remove_suffix( str.size() - ( str.find_last_not_of( ' ' ) + 1 ) );
+  return str;
+}
+
+// Returns the first character in [curr, end) that may terminate a plain scalar,
+// or end if there isn't one. Whole 16-byte blocks are classified with SSE2 when
+// available; the remaining tail is handled one character at a time.
+const char* FindEndScalar( const char* curr, const char* end );
+
+// Stage-1 index of the characters that may end a plain scalar (kEndScalar), one
+// bit per byte of text. It is built in one SIMD pass over the whole text, after
+// which the parser finds each structural character by scanning 64 bits at a
+// time instead of classifying bytes again. Quotes aren't indexed: whether ' or
+// " starts a quoted scalar depends on the preceding token, e.g. "don't".
+class StructuralIndex
+{
+public:
+
+  void Build( std::string_view );
+
+  bool IsBuilt() const
+  {
+    return base_ != nullptr;
+  }
+
+  void Clear()
+  {
+    base_ = nullptr;
+    bits_.clear();
+  }
+
+  // Same result as FindEndScalar; curr and end must be within the indexed text
+  const char* FindNext( const char* curr, const char* end ) const
+  {
+    assert( IsBuilt() && curr >= base_ );
+    if( curr >= end )
+      return end;
+    auto pos = static_cast<size_t>( curr - base_ );
+    auto word = pos / kWordBits;
+    auto bits = bits_[ word ] & ( ~uint64_t( 0 ) << ( pos % kWordBits ) );
+    while( bits == 0 )
+    {
+      if( ++word == bits_.size() )
+        return end;
+      bits = bits_[ word ];
+    }
+    auto found = base_ + word * kWordBits + static_cast<size_t>( std::countr_zero( bits ) );
+    return ( found < end ) ? found : end;
+  }
+
+private:
+
+  static constexpr size_t kWordBits = 64u;
+
+  const char*           base_ = nullptr;
+  std::vector<uint64_t> bits_;
+};
+
+// Returns the end of the value following the ':' of a key without parsing it:
+// the ',', ']' or '}' ending a flow value, the line end following a block value,
+// or end. Block values continue on lines that are blank, comments or indented
+// beyond keyLevel. Brackets and quoted scalars may span lines. lines receives
+// the number of line ends skipped.
+const char* SkipValue( const char* curr, const char* end, size_t keyLevel, bool isFlow, size_t& lines );
+
+// Returns the first quote character in [curr, end), or end if there isn't one.
+// Backslashes are also returned for double quotes, since they start escapes.
+const char* FindEndQuoted( const char* curr, const char* end, char quote );
+
+// Appends the text of a quoted scalar to str with escapes decoded: '' for
+// single quotes; \n, \", \uXXXX and the rest for double quotes. Line breaks
+// are folded: a single break becomes a space and n breaks become n-1 line
+// ends, without the blanks around them. Returns false for an invalid escape
+// sequence, setting errPos to its backslash.
+bool DecodeQuoted( std::string_view text, char quote, std::string& str, size_t& errPos );
+
+struct BlockScalar
+{
+  std::string_view str;         // refers to the source when no assembly was needed
+  const char*      next = nullptr; // start of the line following the scalar; nullptr on error
+  size_t           lines = 0u;  // line ends before next
+  size_t           indent = 0u; // of the content lines; 0 if there were none
+};
+
+// Parses the block scalar whose '|' or '>' indicator is at curr. Content lines
+// must be indented beyond parentIndent. A single line is returned as a view of
+// the source where chomping allows; otherwise lines are assembled in scratch.
+BlockScalar ParseBlockScalar( const char* curr, const char* end, size_t parentIndent, std::string& scratch );
+
+// Returns the start of the first line from curr that ends a block scalar with
+// the given content indentation, or end if every complete line continues it
+const char* FindBlockEnd( const char* curr, const char* end, size_t indent );
+
+// Events of an anchored node, recorded so aliases can replay them
+enum class EventType : uint8_t
+{
+  StartSequence,
+  EndSequence,
+  StartMapping,
+  EndMapping,
+  Key,
+  Scalar,
+  Tag,   // precedes the node it tags
+  Anchor, // recorded for ParseChunked only
+  SequenceEntry
+};
+
+class AnchorRecorder
+{
+public:
+
+  struct Event
+  {
+    EventType       type = EventType::Scalar;
+    YamlScalarStyle style = YamlScalarStyle::Plain;
+    size_t          textPos = 0u; // key or scalar within the recorded text
+    size_t          textSize = 0u;
+  };
+
+  struct Range
+  {
+    size_t first = 0u;
+    size_t count = 0u; // zero for an anchored null
+  };
+
+  // True while an anchor awaits its node or a node is being recorded
+  bool IsRecording() const
+  {
+    return isPending_ || !recordings_.empty();
+  }
+
+  // The node starting with the next recorded event gets the anchor
+  void SetPending( std::string_view anchor );
+  void Record( EventType, std::string_view = {}, YamlScalarStyle = YamlScalarStyle::Plain );
+  const Range* Find( std::string_view anchor ) const;
+  void Clear();
+
+  // Recording may add events, so callers should copy the event
+  const Event& GetEvent( size_t i ) const
+  {
+    return events_[ i ];
+  }
+
+  std::string_view GetText( const Event& event ) const
+  {
+    return std::string_view( text_ ).substr( event.textPos, event.textSize );
+  }
+
+private:
+
+  struct Recording
+  {
+    std::string anchor;
+    size_t      firstEvent = 0u;
+    size_t      depth = 0u; // collections opened and not yet closed
+  };
+
+  std::vector<Event>                        events_;
+  std::string                               text_; // copied, since the source may not outlive the node
+  std::vector<Recording>                    recordings_;
+  using AnchorMap = std::map<std::string, Range, std::less<>>;
+
+  void SetAnchor( std::string_view, Range );
+
+  AnchorMap                                 anchors_;
+  std::vector<AnchorMap::node_type>         spareAnchors_; // cleared map nodes for reuse
+  std::string                               pending_;
+  bool                                      isPending_ = false;
+};
+
+// Returns true if the line starting at curr is a "---" or "..." document marker
+bool IsDocumentMarker( const char* curr, const char* end );
+
+// Returns true if the line starting at curr has something other than blanks,
+// comments or directives
+bool IsContentLine( const char* curr, const char* end );
+
+struct DocumentText
+{
+  std::string_view text;
+  size_t line = 1u; // line number of the first line of text
 };
 
-class YamlParser
+// Splits a multi-document stream into text that can be parsed independently.
+// Document markers only count at the start of a line, and YAML doesn't allow
+// them inside quoted scalars, so a line scan suffices. Text without content,
+// such as leading comments, stays with its neighboring document.
+std::vector<DocumentText> SplitDocuments( std::string_view );
+
+// Splits a single document into about pieceCount pieces for ParseChunked. Each
+// piece starts with a line at column 0 beginning a top-level key, or a "- "
+// entry if the top level is a sequence, where the parser is always back at the
+// root. Text with document markers or indented top-level content is returned
+// whole. Multi-line flow collections or quoted scalars may still span a split;
+// parsing the pieces detects this.
+std::vector<DocumentText> SplitTopLevel( std::string_view, size_t pieceCount, bool& isSequence );
+
+// Events of one piece of a document parsed by ParseChunked, kept until they
+// can be delivered in document order. Text within the source is referenced;
+// anything else, such as decoded escapes, is copied.
+class ChunkRecorder : public YamlStaticHandler
+{
+public:
+
+  struct Event
+  {
+    EventType       type = EventType::Scalar;
+    YamlScalarStyle style = YamlScalarStyle::Plain;
+    bool            isCopied = false; // text is in the recorder rather than the source
+    size_t          textPos = 0u;
+    size_t          textSize = 0u;
+    size_t          pos = 0u;       // parser position within the source
+    size_t          line = 0u;
+    size_t          lineStart = 0u; // offset of the start of the line
+  };
+
+  explicit ChunkRecorder( std::string_view source ) : source_( source ) {}
+
+  void onStartSequence() { Add( EventType::StartSequence ); }
+  void onEndSequence() { Add( EventType::EndSequence ); }
+  void onStartMapping() { Add( EventType::StartMapping ); }
+  void onEndMapping() { Add( EventType::EndMapping ); }
+  bool onKey( std::string_view key ) { Add( EventType::Key, key ); return true; }
+  bool onScalar( std::string_view scalar, YamlScalarStyle style ) { Add( EventType::Scalar, scalar, style ); return true; }
+  void onTag( std::string_view tag ) { Add( EventType::Tag, tag ); }
+  void onAnchor( std::string_view anchor ) { Add( EventType::Anchor, anchor ); }
+  void onSequenceEntry() { Add( EventType::SequenceEntry ); }
+  void onErrorCode( const YamlError& ) { hasError_ = true; }
+
+  bool HasError() const
+  {
+    return hasError_;
+  }
+
+  std::span<const Event> GetEvents() const
+  {
+    return events_;
+  }
+
+  std::string_view GetText( const Event& event ) const
+  {
+    return std::string_view( event.isCopied ? text_ : source_ ).substr( event.textPos, event.textSize );
+  }
+
+  const char* const* curr_ = nullptr; // position of the parser producing the events
+  const size_t* line_ = nullptr;
+  const size_t* lineStart_ = nullptr;
+
+private:
+
+  void Add( EventType, std::string_view = {}, YamlScalarStyle = YamlScalarStyle::Plain );
+
+private:
+
+  std::string_view   source_;
+  std::vector<Event> events_;
+  std::string        text_;
+  bool               hasError_ = false;
+};
+
+// Calls task( i ) for each i in [0, count), spread across threadCount threads
+// including the calling thread. Threads take the next index as they finish,
+// so uneven task sizes balance out.
+template <typename Task>
+void RunParallel( size_t count, size_t threadCount, const Task& task )
+{
+  if( threadCount == 0 )
+    threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+  threadCount = std::min( threadCount, count );
+
+  std::atomic<size_t> next = 0;
+  auto worker = [&]()
+  {
+    for( size_t i = next++; i < count; i = next++ )
+      task( i );
+  };
+  std::vector<std::jthread> threads;
+  for( size_t t = 1; t < threadCount; ++t )
+    threads.emplace_back( worker );
+  worker();
+}
+
+// Like RunParallel, but also calls deliver( i ) on the calling thread for each
+// i in order, as soon as task( i ) and every earlier delivery have finished.
+// The calling thread delivers whatever is ready before taking another task.
+// Once deliver returns false, no further tasks start and false is returned.
+template <typename Task, typename Deliver>
+bool RunOrdered( size_t count, size_t threadCount, const Task& task, const Deliver& deliver )
+{
+  if( threadCount == 0 )
+    threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+  threadCount = std::min( threadCount, count );
+
+  std::atomic<size_t> next = 0;
+  std::mutex mutex;
+  std::condition_variable taskDone;
+  std::vector<uint8_t> isDone( count ); // guarded by mutex
+  auto runTask = [&]( size_t i )
+  {
+    task( i );
+    std::lock_guard lock( mutex );
+    isDone[ i ] = true;
+    taskDone.notify_one(); // only the calling thread waits
+  };
+  auto worker = [&]()
+  {
+    for( size_t i = next++; i < count; i = next++ )
+      runTask( i );
+  };
+  std::vector<std::jthread> threads;
+  for( size_t t = 1; t < threadCount; ++t )
+    threads.emplace_back( worker );
+
+  for( size_t delivered = 0; delivered < count; ++delivered )
+  {
+    for( ;; )
+    {
+      {
+        std::unique_lock lock( mutex );
+        if( !isDone[ delivered ] && next >= count )
+          taskDone.wait( lock, [&]() { return isDone[ delivered ] != 0; } );
+        if( isDone[ delivered ] )
+          break;
+      }
+      if( size_t i = next++; i < count )
+        runTask( i );
+    }
+    if( !deliver( delivered ) )
+    {
+      next = count; // other threads finish their current task
+      return false;
+    }
+  }
+  return true;
+}
+
+} // end namespace Yaml::Detail
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parses YAML text, calling Handler for each event. YamlParser uses the
+// virtual YamlHandler interface; BasicYamlParser<T> with a concrete handler
+// type avoids the indirect calls.
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+class BasicYamlParser
 {
 public:
 
-  YamlParser() = delete;
-  YamlParser( const YamlParser& ) = delete;
-  YamlParser( YamlParser&& ) = delete;
-  YamlParser& operator=( const YamlParser& ) = delete;
-  YamlParser&& operator=( YamlParser&& ) = delete;
+  BasicYamlParser() = delete;
+  BasicYamlParser( const BasicYamlParser& ) = delete;
+  BasicYamlParser( BasicYamlParser&& ) = delete;
+  BasicYamlParser& operator=( const BasicYamlParser& ) = delete;
+  BasicYamlParser&& operator=( BasicYamlParser&& ) = delete;
 
-  YamlParser( std::string_view, YamlHandler& );
+  BasicYamlParser( std::string_view, Handler& );
   bool Parse();
 
+  // Prepares to parse new text as if newly constructed, but keeping settings
+  // such as SetMaxDepth() and the memory of internal buffers, so that parsing
+  // many small documents with one parser doesn't allocate
+  void Reset( std::string_view );
+  void Reset( std::string_view, Handler& );
+
+  // Parses the file in place from a read-only memory mapping
+  static bool ParseFile( const std::filesystem::path&, Handler& );
+
+  // Parses the documents of a multi-document stream concurrently. getHandler is
+  // invoked on the calling thread in document order before parsing starts, and
+  // each document's events go to the handler returned for its index. A thread
+  // count of zero uses all hardware threads. Returns false if any document fails.
+  static bool ParseParallel( std::string_view,
+                             const std::function<Handler&( size_t docIndex )>& getHandler,
+                             size_t threadCount = 0 );
+
+  // Parses a single large document on several threads. The text is split at
+  // lines starting top-level keys or sequence entries, the pieces are parsed
+  // concurrently, and their events reach the handler in document order on the
+  // calling thread, each piece's as soon as the pieces before it are
+  // delivered. GetLine(), GetCol() and GetOffset() remain valid during
+  // callbacks.
+  // Small texts and multiple documents are parsed by Parse() instead. From a
+  // piece that can't be parsed on its own, such as one with an alias to an
+  // anchor in another piece, the rest of the text is parsed on the calling
+  // thread as Parse() would, which also reports any error. A thread count of
+  // zero uses all hardware threads.
+  bool ParseChunked( size_t threadCount = 0 );
+
+  // Position of the character being parsed; valid during handler callbacks.
+  // Only offsets are tracked while parsing; the column is derived from the
+  // offset of the start of the line when asked for.
+  size_t GetLine() const
+  {
+    return line_;
+  }
+
+  size_t GetCol() const
+  {
+    return GetOffset() - lineStart_ + 1;
+  }
+
+  // Bytes from the start of the text to the character being parsed
+  size_t GetOffset() const
+  {
+    return baseOffset_ + static_cast<size_t>( curr_ - begin_ );
+  }
+
+  // Nesting deeper than this, counting both indentation and brackets, is
+  // reported as an error rather than parsed
+  static constexpr size_t kDefaultMaxDepth = 1024u;
+  void SetMaxDepth( size_t maxDepth )
+  {
+    maxDepth_ = maxDepth;
+  }
+
+  // Limits the events that aliases may replay in a document, and the bytes of
+  // the keys and scalars among them, guarding against exponential expansion
+  // such as the "billion laughs" attack. Handlers with
+  // onAlias( std::string_view ) resolve aliases themselves, e.g. by sharing a
+  // node, and aren't limited.
+  static constexpr size_t kDefaultMaxAliasExpansion = 1'000'000u;
+  void SetMaxAliasExpansion( size_t maxEvents )
+  {
+    maxAliasExpansion_ = maxEvents;
+  }
+
+  static constexpr size_t kDefaultMaxAliasBytes = size_t( 64 ) << 20;
+  void SetMaxAliasBytes( size_t maxBytes )
+  {
+    maxAliasBytes_ = maxBytes;
+  }
+
+  // Parse() first indexes the structural characters of the whole text, then
+  // finds the end of each plain scalar, comment and line from the index
+  // rather than rescanning the text. Usually faster for large files; needs one
+  // bit per byte of text. Off by default.
+  void UseStructuralIndex( bool useIndex )
+  {
+    useStructuralIndex_ = useIndex;
+  }
+
+  // Tagged scalars with a decoder in the registry reach the handler decoded.
+  // Without a registry, the default, scalars are passed on as written.
+  void SetTagRegistry( const YamlTagRegistry* tagRegistry )
+  {
+    tagRegistry_ = tagRegistry;
+  }
+
 private:
 
   struct Indent
@@ -61,14 +837,35 @@ private:
     bool isSequence = false;
   };
 
-  // Helper to manage simple YAML indent stack; mimics std::stack API
+  // How far a token suspended at the end of the available text was scanned,
+  // so streaming resumes the scan rather than starting over with every chunk.
+  // Offsets are from the start of the whole text.
+  struct Suspension
+  {
+    static constexpr size_t kNone = SIZE_MAX;
+
+    size_t tokenOffset = kNone; // first character of the token
+    size_t scanOffset = 0u;     // the token continues at least this far
+    bool   hasEscapes = false;  // quoted scalar
+    size_t blockIndent = 0u;    // block scalar content indentation, once known
+  };
+
+  // Helper to manage simple YAML indent stack; mimics std::stack API. Typical
+  // depths fit in the inline buffer; deeper documents move to the heap.
   class YamlStack
   {
-    static constexpr size_t kMaxStackSize = 32u;
+    static constexpr size_t kInlineSize = 32u;
   public:
+    YamlStack() = default;
+    YamlStack( const YamlStack& ) = delete;
+    YamlStack( YamlStack&& ) = delete;
+    YamlStack& operator=( const YamlStack& ) = delete;
+    YamlStack&& operator=( YamlStack&& ) = delete;
+
     void push( Indent indent )
     {
-      assert( size_ < kMaxStackSize - 1 );
+      if( size_ == capacity_ ) [[unlikely]]
+        grow();
       stack_[ size_++ ] = indent;
     }
     void pop()
@@ -85,43 +882,602 @@ private:
     {
       return size_ == 0;
     }
+    void clear() // keeps any heap buffer
+    {
+      size_ = 0u;
+    }
     size_t size() const
     {
       return size_;
+    }
+    Indent operator[]( size_t i ) const // from the bottom
+    {
+      assert( i < size_ );
+      return stack_[ i ];
     }  
   private:
-    std::array<Indent, kMaxStackSize> stack_;
+    void grow()
+    {
+      std::vector<Indent> heapStack( capacity_ * 2 );
+      std::copy( stack_, stack_ + size_, heapStack.begin() );
+      heapStack_.swap( heapStack );
+      stack_ = heapStack_.data();
+      capacity_ = heapStack_.size();
+    }
+  private:
+    std::array<Indent, kInlineSize> inlineStack_;
+    std::vector<Indent> heapStack_;
+    Indent* stack_ = inlineStack_.data();
+    size_t capacity_ = kInlineSize;
     size_t size_ = 0u;
   };
 
-  bool Error( std::string_view ) const;
-  void Push( Indent );
+  friend class YamlStreamParser;
+  friend class YamlReader;
+  template <typename OtherHandler>
+  requires IsYamlHandler<OtherHandler>
+  friend class BasicYamlParser; // ParseChunked configures the parsers of its pieces
+
+  bool ParseText();
+  bool ParseStep();
+  void StartDocument();
+  void EndDocument();
+  bool Error( YamlErrorCode, std::string_view detail = {} ) const;
+  static void ReportError( Handler&, const YamlError& );
+  bool Push( Indent );
   bool Pop();
+  bool IsAtMaxDepth() const;
   char PeekNext() const;
   Indent GetIndent();
-  bool SkipStartDocument();
+  bool IsDocumentMarker() const;
+  void ParseDocumentMarker();
+  bool IsContentLine() const;
   void SkipSpaces();
+  void NextLines( const char* );
   void SkipLine();
+  void SkipValue();
   void HandleMissingNull();
   bool IsNormalChar() const;
   bool ParseNode();
   bool ParsePlain();
   bool ParseQuoted( char );
-  bool OutputScalar( std::string_view );
+  bool ParseBlock();
+  std::string_view ParseName();
+  bool ParseAnchor();
+  bool ParseAlias();
+  bool ParseTag();
+  const char* FindEndScalar( const char* ) const;
+  bool Replay( Yaml::Detail::AnchorRecorder::Range );
+  bool EmitEvent( Yaml::Detail::EventType, std::string_view, YamlScalarStyle );
+  void EmitStart( bool isSequence );
+  void EmitEnd( bool isSequence );
+  void EmitEntry();
+  YamlKeyAction EmitKey( std::string_view );
+  bool OutputScalar( std::string_view, YamlScalarStyle );
+  bool EmitScalar( std::string_view, YamlScalarStyle );
 
 private:
 
+  const char*  begin_;       // start of the text in memory
   const char*  curr_;        // current YAML char being evaluated
   const char*  end_;         // one beyond last char of YAML text
+  size_t       baseOffset_ = 0u; // offset of begin_ within the whole text
   size_t       line_ = 1u;   // YAML line number
-  size_t       col_ = 0u;    // YAML column number
-  YamlHandler& yamlHandler_; // callbacks
+  size_t       lineStart_ = 0u; // offset of the first character of the current line
+  size_t       lineIndent_ = 0u; // leading spaces of the current line
+  Handler*     yamlHandler_; // callbacks
   YamlStack    yamlStack_;   // current indentation level
+  size_t       flowDepth_ = 0u; // open flow collections, e.g. [ or {
+  size_t       maxDepth_ = kDefaultMaxDepth;
   bool         completeKeyValuePair_ = true;
+  bool         isDocumentOpen_ = false;
+  bool         hasContent_ = false;  // current document has more than comments/directives
+  bool         isFinalText_ = true;  // false if more text may follow end_
+  bool         isSuspended_ = false; // stopped at a token continuing beyond end_
+  Suspension   suspension_;
+  std::string  scratch_;     // decoded scalar text; reused to avoid allocations
+  bool         isMuted_ = false; // events of a skipped value aren't reported
+  size_t       muteDepth_ = 0u;  // collections opened within the skipped value
+  size_t       expandedEvents_ = 0u; // replayed by aliases in this document
+  size_t       expandedBytes_ = 0u;
+  size_t       maxAliasExpansion_ = kDefaultMaxAliasExpansion;
+  size_t       maxAliasBytes_ = kDefaultMaxAliasBytes;
+  Yaml::Detail::AnchorRecorder anchors_;
+  const YamlTagRegistry* tagRegistry_ = nullptr;
+  const YamlTagRegistry::Decoder* tagDecoder_ = nullptr; // for the next scalar
+  std::string  tag_;      // most recent tag, expanded
+  Yaml::TaggedValue tagValue_; // decoded tagged scalar
+  bool         useStructuralIndex_ = false;
+  Yaml::Detail::StructuralIndex structuralIndex_; // built by Parse() if used
 
-}; // class YamlParser
+  // ParseChunked pieces; more pieces than threads balance uneven records
+  static constexpr size_t kMinChunkSize = 64u * 1024u;
+  static constexpr size_t kChunksPerThread = 4u;
 
-///////////////////////////////////////////////////////////////////////////////
+  // Handlers may resolve aliases themselves instead of having events replayed
+  static constexpr bool kHandlesAliases = requires( Handler& handler, std::string_view name )
+  {
+    { handler.onAlias( name ) } -> std::convertible_to<bool>;
+  };
+
+}; // class BasicYamlParser
+
+using YamlParser = BasicYamlParser<YamlHandler>;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Keeps parsers for reuse across many small documents. Once the parsers'
+// buffers have grown to fit, acquiring and parsing doesn't allocate. Safe to
+// use from multiple threads; the pool must outlive its leases.
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+class BasicYamlParserPool
+{
+public:
+
+  using Parser = BasicYamlParser<Handler>;
+
+  // Exclusive use of a pooled parser, returned to the pool on destruction
+  class Lease
+  {
+  public:
+
+    Lease() = delete;
+    Lease( const Lease& ) = delete;
+    Lease( Lease&& ) = delete;
+    Lease& operator=( const Lease& ) = delete;
+    Lease&& operator=( Lease&& ) = delete;
+
+    ~Lease()
+    {
+      pool_.Release( std::move( parser_ ) );
+    }
+
+    Parser& operator*() const
+    {
+      return *parser_;
+    }
+
+    Parser* operator->() const
+    {
+      return parser_.get();
+    }
+
+  private:
+
+    friend class BasicYamlParserPool;
+
+    Lease( BasicYamlParserPool& pool, std::unique_ptr<Parser> parser ) :
+      pool_( pool ),
+      parser_( std::move( parser ) )
+    {
+    }
+
+  private:
+
+    BasicYamlParserPool&    pool_;
+    std::unique_ptr<Parser> parser_;
+  };
+
+  BasicYamlParserPool() = default;
+  BasicYamlParserPool( const BasicYamlParserPool& ) = delete;
+  BasicYamlParserPool( BasicYamlParserPool&& ) = delete;
+  BasicYamlParserPool& operator=( const BasicYamlParserPool& ) = delete;
+  BasicYamlParserPool&& operator=( BasicYamlParserPool&& ) = delete;
+
+  // A parser reset to the given text and handler; settings such as
+  // SetMaxDepth() are kept from its previous use
+  Lease Acquire( std::string_view yaml, Handler& handler )
+  {
+    std::unique_lock lock( mutex_ );
+    if( parsers_.empty() )
+    {
+      lock.unlock();
+      return Lease( *this, std::make_unique<Parser>( yaml, handler ) );
+    }
+    auto parser = std::move( parsers_.back() );
+    parsers_.pop_back();
+    lock.unlock();
+    parser->Reset( yaml, handler );
+    return Lease( *this, std::move( parser ) );
+  }
+
+private:
+
+  void Release( std::unique_ptr<Parser> parser )
+  {
+    std::lock_guard lock( mutex_ );
+    parsers_.push_back( std::move( parser ) );
+  }
+
+private:
+
+  std::mutex                           mutex_;
+  std::vector<std::unique_ptr<Parser>> parsers_; // idle
+};
+
+using YamlParserPool = BasicYamlParserPool<YamlHandler>;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Push-style parser for YAML that arrives in pieces, e.g. from a pipe or a
+// socket. Complete lines are parsed as they arrive; a partial line, or a
+// quoted scalar that isn't yet terminated, is carried over to the next Feed().
+// Memory use is bounded by the longest token rather than the input size.
+// Strings passed to the handler are only valid for the duration of the callback.
+
+class YamlStreamParser
+{
+public:
+
+  YamlStreamParser() = delete;
+  YamlStreamParser( const YamlStreamParser& ) = delete;
+  YamlStreamParser( YamlStreamParser&& ) = delete;
+  YamlStreamParser& operator=( const YamlStreamParser& ) = delete;
+  YamlStreamParser&& operator=( YamlStreamParser&& ) = delete;
+
+  explicit YamlStreamParser( YamlHandler& );
+  bool Feed( std::string_view ); // false on error or if the handler stopped parsing
+  bool Finish();                 // call once all text has been fed
+
+private:
+
+  void StartDocument();
+  bool ParseBuffered( size_t, bool isFinalText );
+
+private:
+
+  YamlParser  yamlParser_;
+  std::string buffer_;            // text not yet consumed by the parser
+  size_t      consumed_ = 0u;     // text discarded from the front of buffer_
+  bool        isStarted_ = false;
+  bool        isStopped_ = false;
+
+}; // class YamlStreamParser
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Pull-style alternative to YamlHandler callbacks. Each call to Next() parses
+// only as far as needed to produce the next event, so callers can stop at any
+// point without parsing the remainder.
+
+struct YamlEvent
+{
+  enum class Type : uint8_t
+  {
+    StartDocument,
+    EndDocument,
+    StartSequence,
+    EndSequence,
+    StartMapping,
+    EndMapping,
+    Key,
+    Scalar,
+    Error
+  };
+
+  Type             type = Type::StartDocument;
+  std::string_view str;       // key, scalar or error message
+  YamlScalarStyle  style = YamlScalarStyle::Plain; // for scalars
+  size_t           line = 0u; // position where the event was recognized
+  size_t           col = 0u;
+  size_t           offset = 0u; // bytes from the start of the text
+};
+
+class YamlReader
+{
+public:
+
+  YamlReader() = delete;
+  YamlReader( const YamlReader& ) = delete;
+  YamlReader( YamlReader&& ) = delete;
+  YamlReader& operator=( const YamlReader& ) = delete;
+  YamlReader&& operator=( YamlReader&& ) = delete;
+
+  explicit YamlReader( std::string_view );
+
+  // Returns false once all events have been read; an Error event is last
+  bool Next( YamlEvent& );
+
+  // Skips the value of the key just returned by Next(), including any nested
+  // collections, without producing events for it. False if the last event
+  // wasn't a key.
+  bool Skip();
+
+private:
+
+  // Collects the events produced by a single parsing step
+  class EventQueue : public YamlStaticHandler
+  {
+  public:
+    void onStartDocument() { Add( YamlEvent::Type::StartDocument ); }
+    void onEndDocument() { Add( YamlEvent::Type::EndDocument ); }
+    void onStartSequence() { Add( YamlEvent::Type::StartSequence ); }
+    void onEndSequence() { Add( YamlEvent::Type::EndSequence ); }
+    void onStartMapping() { Add( YamlEvent::Type::StartMapping ); }
+    void onEndMapping() { Add( YamlEvent::Type::EndMapping ); }
+    bool onKey( std::string_view key ) { Add( YamlEvent::Type::Key, key ); return true; }
+    bool onScalar( std::string_view scalar, YamlScalarStyle style ) { Add( YamlEvent::Type::Scalar, scalar, style ); return true; }
+    void onErrorCode( const YamlError& );
+
+    void Add( YamlEvent::Type, std::string_view = {}, YamlScalarStyle = YamlScalarStyle::Plain );
+    bool Pop( YamlEvent& );
+    bool SkipValue();
+
+    const YamlReader* reader_ = nullptr; // source of event positions
+
+  private:
+    std::vector<YamlEvent> events_; // reused across steps
+    size_t                 next_ = 0u;
+    std::string            errMessage_;
+  };
+
+private:
+
+  EventQueue                  events_;
+  BasicYamlParser<EventQueue> yamlParser_;
+  bool                        isStarted_ = false;
+  bool                        isDone_ = false;
+  bool                        isAtKey_ = false; // last event was a key
+
+}; // class YamlReader
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Extracts scalars by path, e.g. "servers[2].name", without building a DOM.
+// Values that can't contain any requested path are skipped unparsed, and
+// parsing stops as soon as every path is found. Only the first document of a
+// stream is searched.
+//
+// The parser reports the keys of a mapping within a block sequence entry
+// ("- key: value") directly in the sequence, so the query opens a mapping for
+// them at each entry, addressed as "list[0].key".
+
+class YamlQuery
+{
+public:
+
+  YamlQuery() = default;
+  YamlQuery( const YamlQuery& ) = delete;
+  YamlQuery( YamlQuery&& ) = delete;
+  YamlQuery& operator=( const YamlQuery& ) = delete;
+  YamlQuery&& operator=( YamlQuery&& ) = delete;
+
+  // Adds a path of dot-separated keys and [index] subscripts; false if the
+  // path is malformed. Paths are numbered in the order they are added.
+  bool AddPath( std::string_view );
+
+  // Finds the paths in the YAML text; false on a syntax error
+  bool Run( std::string_view );
+
+  // Scalar found for the given path. Refers to the text passed to Run(), or to
+  // a copy owned by the query if escape sequences were decoded.
+  std::optional<std::string_view> GetValue( size_t pathIndex ) const;
+
+private:
+
+  static constexpr size_t kNoIndex = size_t( -1 );
+
+  struct PathStep
+  {
+    std::string key;
+    size_t      index = kNoIndex; // kNoIndex for a key
+  };
+  using Path = std::vector<PathStep>;
+
+  // Tracks the location of parser events and matches it against the paths
+  class Matcher : public YamlStaticHandler
+  {
+  public:
+    Matcher( YamlQuery& query, std::string_view yaml ) : query_( query ), yaml_( yaml ) {}
+
+    void onEndDocument() { isDone_ = true; }
+    void onStartSequence() { StartCollection( true ); }
+    void onEndSequence();
+    void onStartMapping() { StartCollection( false ); }
+    void onEndMapping() { EndCollection(); }
+    void onSequenceEntry();
+    YamlKeyAction onKey( std::string_view );
+    bool onScalar( std::string_view );
+    void onErrorCode( const YamlError& ) { hasError_ = true; }
+
+    bool HasError() const
+    {
+      return hasError_;
+    }
+
+  private:
+
+    // An open collection and the position within it
+    struct Frame
+    {
+      bool             isSequence = false;
+      bool             isEntry = false; // mapping of a block sequence entry
+      bool             hasKey = false;
+      size_t           index = 0u;
+      std::string_view key;
+    };
+
+    void StartCollection( bool isSequence );
+    void EndCollection();
+    void EndValue();
+    bool IsMatch( const Path&, bool isPrefix ) const;
+
+  private:
+    YamlQuery&         query_;
+    std::string_view   yaml_;
+    std::vector<Frame> frames_;
+    bool               isDone_ = false;
+    bool               hasError_ = false;
+  };
+
+private:
+
+  std::vector<Path>                            paths_;
+  std::vector<std::optional<std::string_view>> values_;
+  std::vector<std::string>                     decodedValues_; // values not in the source
+  size_t                                       foundCount_ = 0u;
+
+}; // class YamlQuery
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Read-only memory mapping of a file; avoids reading large YAML files into
+// a string before parsing them
+
+class YamlFile
+{
+public:
+
+  YamlFile() = delete;
+  YamlFile( const YamlFile& ) = delete;
+  YamlFile( YamlFile&& ) = delete;
+  YamlFile& operator=( const YamlFile& ) = delete;
+  YamlFile&& operator=( YamlFile&& ) = delete;
+
+  explicit YamlFile( const std::filesystem::path& );
+  ~YamlFile();
+
+  bool IsOpen() const
+  {
+    return isOpen_;
+  }
+
+  std::string_view GetText() const
+  {
+    // Empty files have no mapping, but the parser requires valid pointers
+    return ( data_ == nullptr ) ? std::string_view( "" ) : std::string_view( data_, size_ );
+  }
+
+private:
+
+  const char* data_ = nullptr;
+  size_t      size_ = 0u;
+  bool        isOpen_ = false;
+
+}; // class YamlFile
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Node of a YamlDocument tree. Keys and scalars refer directly into the parsed
+// text. The children of a collection are stored contiguously; for mappings,
+// each child carries its key.
+
+struct YamlNode
+{
+  enum class Type : uint8_t
+  {
+    Scalar,
+    Sequence,
+    Mapping
+  };
+
+  Type             type = Type::Scalar;
+  std::string_view key;              // only set for members of a mapping
+  std::string_view scalar;           // only set for scalars
+  const YamlNode*  children = nullptr;
+  size_t           childCount = 0u;
+
+  bool IsScalar() const
+  {
+    return type == Type::Scalar;
+  }
+
+  std::span<const YamlNode> GetChildren() const
+  {
+    return std::span<const YamlNode>( children, childCount );
+  }
+
+  // Returns the first child with the given key, or nullptr if there isn't one
+  const YamlNode* Find( std::string_view ) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Tree of YamlNodes built from YAML text. All nodes live in an arena owned by
+// the document and are released together. Scalars aren't copied, so the text
+// must outlive the document.
+
+class YamlDocument
+{
+public:
+
+  YamlDocument() = default;
+  YamlDocument( const YamlDocument& ) = delete;
+  YamlDocument( YamlDocument&& ) = delete;
+  YamlDocument& operator=( const YamlDocument& ) = delete;
+  YamlDocument&& operator=( YamlDocument&& ) = delete;
+
+  // Replaces any previous tree. A thread count other than one parses a large
+  // single document in pieces concurrently; see BasicYamlParser::ParseChunked.
+  bool Parse( std::string_view, size_t threadCount = 1 );
+  bool Parse( std::string&&, size_t threadCount = 1 ) = delete; // the text must outlive the document
+  void Clear();
+
+  // The root of each document in a multi-document stream is a mapping
+  std::span<const YamlNode> GetDocuments() const
+  {
+    return documents_;
+  }
+
+  // Root of the first document
+  const YamlNode& GetRoot() const
+  {
+    assert( !documents_.empty() );
+    return documents_.front();
+  }
+
+  std::string_view GetError() const
+  {
+    return error_;
+  }
+
+  size_t GetErrorLine() const
+  {
+    return errorLine_;
+  }
+
+  size_t GetErrorCol() const
+  {
+    return errorCol_;
+  }
+
+private:
+
+  // Bump allocator; everything is freed at once when the arena is cleared
+  class Arena
+  {
+  public:
+    template <typename T>
+    T* Allocate( size_t count )
+    {
+      static_assert( std::is_trivially_destructible_v<T> );
+      return static_cast<T*>( Allocate( count * sizeof( T ), alignof( T ) ) );
+    }
+    void* Allocate( size_t bytes, size_t alignment );
+    void Clear();
+  private:
+    static constexpr size_t kBlockSize = 64u * 1024u;
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte* next_ = nullptr; // next free byte in the current block
+    std::byte* end_ = nullptr;  // end of the current block
+  };
+
+  class Builder;
+  friend class Builder;
+
+private:
+
+  Arena                     arena_;
+  std::span<const YamlNode> documents_;
+  std::string               error_;
+  size_t                    errorLine_ = 0u;
+  size_t                    errorCol_ = 0u;
+
+}; // class YamlDocument
+
+///////////////////////////////////////////////////////////////////////////////
 
 namespace Yaml {
 
@@ -138,58 +1494,1539 @@ struct Special
 };
 
 Special GetSpecialChars( std::string_view );
+char GetSafeQuote( std::string_view );
 std::string CreateSafeScalar( std::string_view );
 std::string CreateKeyValue( std::string_view tag, std::string_view scalar );
 
-// Given an input container, creates a YAML formatted output sequence
-// e.g. "['first','second','third']"
-
+// Containers YamlWriter writes as flow sequences
 template <typename Container>
-std::string CreateSequence( const Container& c )
-requires Util::IsContainer<Container>
+concept IsContainer = requires( const Container& c )
+{
+  c.begin();
+  c.end();
+  c.size();
+};
+
+// Entries written as numbers rather than as scalar text
+template <typename T>
+concept IsNumeric = std::is_arithmetic_v<T>;
+
+} // end namespace Yaml
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Writes YAML text directly to an output iterator, so nothing is built in
+// intermediate strings. Works with std::back_inserter for a reusable string,
+// or with a YamlBufferIterator into a caller-provided buffer, e.g.
+//
+//   std::string yaml;
+//   YamlWriter writer( std::back_inserter( yaml ) );
+//   writer.KeyValue( "name", "value" );
+//   writer.BeginSequence( "list" );
+//   writer.Scalar( "entry" );
+//   writer.EndSequence();
+
+// Output iterator into a fixed buffer. Characters beyond the end of the buffer
+// are dropped and flagged rather than written past it. YamlWriter::GetOutput()
+// returns the iterator, e.g.
+//
+//   char buffer[ 256 ];
+//   YamlWriter writer( YamlBufferIterator( buffer, buffer + sizeof( buffer ) ) );
+//   writer.KeyValue( "name", "value" );
+//   auto out = writer.GetOutput();
+//   if( !out.IsTruncated() )
+//     Use( std::string_view( buffer, out.Get() ) );
+
+class YamlBufferIterator
 {
-  if( c.size() == 0 )
-    return "[]";
+public:
+
+  using difference_type = std::ptrdiff_t;
 
-  std::string yaml{ "[" };
-  if( c.size() == 1 )
+  YamlBufferIterator() = default;
+  YamlBufferIterator( char* begin, char* end ) :
+    curr_( begin ),
+    end_( end )
   {
-    if constexpr( Util::IsNumeric<typename Container::value_type> )
-      yaml += Util::ToString( c.front() );
-    else
-      yaml += CreateSafeScalar( c.front() );
-    yaml += ']';
-    return yaml;
   }
 
-  bool isFirstEntry = true;
-  for( const auto& s : c )
+  YamlBufferIterator& operator=( char c )
   {
-    if( !isFirstEntry )
-      yaml += ", ";
-    if constexpr( Util::IsNumeric<typename Container::value_type> )
-      yaml += Util::ToString(s);
+    if( curr_ < end_ )
+      *curr_++ = c;
     else
-      yaml += CreateSafeScalar(s);
-    isFirstEntry = false;
+      isTruncated_ = true;
+    return *this;
   }
-  yaml += ']';
-  return yaml;
-}
 
-template <typename Container>
-std::string CreateKeyValueSeq( std::string_view tag, const Container& c )
-requires Util::IsContainer<Container>
+  // Writing advances the position, so incrementing does nothing
+  YamlBufferIterator& operator*()
+  {
+    return *this;
+  }
+
+  YamlBufferIterator& operator++()
+  {
+    return *this;
+  }
+
+  YamlBufferIterator& operator++( int )
+  {
+    return *this;
+  }
+
+  // One beyond the last character written
+  char* Get() const
+  {
+    return curr_;
+  }
+
+  bool IsTruncated() const
+  {
+    return isTruncated_;
+  }
+
+private:
+
+  char* curr_ = nullptr;
+  char* end_ = nullptr;
+  bool  isTruncated_ = false;
+};
+
+template <typename OutIt>
+requires std::output_iterator<OutIt, char>
+class YamlWriter
 {
-  std::string yaml;
-  yaml += tag;
-  yaml += ": ";
-  yaml += CreateSequence( c );
-  yaml += '\n';
-  return yaml;
-}
+public:
 
-} // end namespace Yaml
+  explicit YamlWriter( OutIt out ) : out_( out ) {}
+
+  // "key: scalar" within a mapping
+  void KeyValue( std::string_view key, std::string_view scalar )
+  {
+    WriteKey( key );
+    Write( ' ' );
+    SafeScalar( scalar );
+    Write( '\n' );
+  }
+
+  // "key: [first, second, third]" within a mapping
+  template <typename Container>
+  void KeyValueSeq( std::string_view key, const Container& c )
+  requires Yaml::IsContainer<Container>
+  {
+    WriteKey( key );
+    Write( ' ' );
+    Sequence( c );
+    Write( '\n' );
+  }
+
+  // "- scalar" within a sequence
+  void Scalar( std::string_view scalar )
+  {
+    WriteDash();
+    SafeScalar( scalar );
+    Write( '\n' );
+  }
+
+  // Starts a nested block mapping; an empty key starts one as a sequence entry
+  void BeginMapping( std::string_view key = {} )
+  {
+    BeginCollection( key );
+  }
+
+  void EndMapping()
+  {
+    EndCollection( "{}" );
+  }
+
+  // Starts a nested block sequence; an empty key starts one as a sequence entry
+  void BeginSequence( std::string_view key = {} )
+  {
+    BeginCollection( key );
+  }
+
+  void EndSequence()
+  {
+    EndCollection( "[]" );
+  }
+
+  // Writes the scalar inline, adding quotes if needed
+  void SafeScalar( std::string_view scalar )
+  {
+    char quote = Yaml::GetSafeQuote( scalar );
+    if( quote )
+      Write( quote );
+    if( quote == '\"' && scalar.find( '\\' ) != std::string_view::npos )
+    {
+      // Backslashes start escape sequences within double quotes
+      for( char c : scalar )
+      {
+        if( c == '\\' )
+          Write( '\\' );
+        Write( c );
+      }
+    }
+    else
+    {
+      Write( scalar );
+    }
+    if( quote )
+      Write( quote );
+  }
+
+  // Writes the container inline as a flow sequence, e.g. "[first, second, third]"
+  template <typename Container>
+  void Sequence( const Container& c )
+  requires Yaml::IsContainer<Container>
+  {
+    Write( '[' );
+    bool isFirstEntry = true;
+    for( const auto& s : c )
+    {
+      if( !isFirstEntry )
+        Write( ", " );
+      if constexpr( Yaml::IsNumeric<typename Container::value_type> )
+        WriteNumber( s );
+      else
+        SafeScalar( s );
+      isFirstEntry = false;
+    }
+    Write( ']' );
+  }
+
+  OutIt GetOutput() const
+  {
+    return out_;
+  }
+
+private:
+
+  static constexpr size_t kIndentSpaces = 2u;
+
+  void Write( char c )
+  {
+    *out_++ = c;
+  }
+
+  void Write( std::string_view str )
+  {
+    out_ = std::copy( str.begin(), str.end(), out_ );
+  }
+
+  template <typename Number>
+  void WriteNumber( Number n )
+  {
+    if constexpr( std::is_same_v<Number, bool> )
+    {
+      Write( n ? "true" : "false" );
+    }
+    else
+    {
+      char buffer[ 64 ]; // longest shortest round trip form of a long double
+      auto [ end, ec ] = std::to_chars( buffer, buffer + sizeof( buffer ), n );
+      Write( std::string_view( buffer, end ) );
+    }
+  }
+
+  void WriteIndent()
+  {
+    // The key line of a collection ends once it's known not to be empty
+    if( isLineEndPending_ )
+    {
+      isLineEndPending_ = false;
+      Write( '\n' );
+    }
+
+    // The first line of a mapping or sequence that is itself a sequence entry
+    // continues on the line of its "- "
+    if( continueLine_ )
+    {
+      continueLine_ = false;
+      return;
+    }
+    for( size_t i = 0; i < depth_ * kIndentSpaces; ++i )
+      Write( ' ' );
+  }
+
+  void WriteKey( std::string_view key )
+  {
+    WriteIndent();
+    Write( key );
+    Write( ':' );
+  }
+
+  void WriteDash()
+  {
+    WriteIndent();
+    Write( "- " );
+  }
+
+  void BeginCollection( std::string_view key )
+  {
+    if( key.empty() )
+    {
+      WriteDash();
+      continueLine_ = true;
+    }
+    else
+    {
+      WriteKey( key );
+      isLineEndPending_ = true;
+    }
+    ++depth_;
+  }
+
+  void EndCollection( std::string_view empty )
+  {
+    assert( depth_ != 0 );
+    --depth_;
+    if( continueLine_ ) // sequence entry without any content
+    {
+      continueLine_ = false;
+      Write( empty );
+      Write( '\n' );
+    }
+    else if( isLineEndPending_ ) // keyed collection without any content
+    {
+      isLineEndPending_ = false;
+      Write( ' ' );
+      Write( empty );
+      Write( '\n' );
+    }
+  }
+
+private:
+
+  OutIt  out_;
+  size_t depth_ = 0u;          // nesting level of block collections
+  bool   continueLine_ = false;
+  bool   isLineEndPending_ = false; // "key:" written for a collection
+
+}; // class YamlWriter
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Yaml {
+
+// Given an input container, creates a YAML formatted output sequence
+// e.g. "['first','second','third']"
+
+template <typename Container>
+std::string CreateSequence( const Container& c )
+requires Yaml::IsContainer<Container>
+{
+  std::string yaml;
+  YamlWriter( std::back_inserter( yaml ) ).Sequence( c );
+  return yaml;
+}
+
+template <typename Container>
+std::string CreateKeyValueSeq( std::string_view tag, const Container& c )
+requires Yaml::IsContainer<Container>
+{
+  std::string yaml;
+  YamlWriter( std::back_inserter( yaml ) ).KeyValueSeq( tag, c );
+  return yaml;
+}
+
+} // end namespace Yaml
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// BasicYamlParser implementation
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+BasicYamlParser<Handler>::BasicYamlParser( std::string_view yaml, Handler& handler ) :
+  begin_( yaml.data() ),
+  curr_( yaml.data() ),
+  end_( yaml.data() + yaml.size() ),
+  yamlHandler_( &handler )
+{
+  yamlStack_.push( Indent{} ); // avoid having to check for empty stack
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::Reset( std::string_view yaml )
+{
+  begin_ = yaml.data();
+  curr_ = yaml.data();
+  end_ = yaml.data() + yaml.size();
+  baseOffset_ = 0u;
+  line_ = 1u;
+  lineStart_ = 0u;
+  lineIndent_ = 0u;
+  yamlStack_.clear();
+  yamlStack_.push( Indent{} );
+  flowDepth_ = 0u;
+  completeKeyValuePair_ = true;
+  isDocumentOpen_ = false;
+  hasContent_ = false;
+  isFinalText_ = true;
+  isSuspended_ = false;
+  suspension_ = {};
+  isMuted_ = false;
+  muteDepth_ = 0u;
+  expandedEvents_ = 0u;
+  expandedBytes_ = 0u;
+  anchors_.Clear();
+  tagDecoder_ = nullptr;
+  structuralIndex_.Clear(); // refers to the previous text
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::Reset( std::string_view yaml, Handler& handler )
+{
+  yamlHandler_ = &handler;
+  Reset( yaml );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::Parse()
+{
+  if( useStructuralIndex_ )
+    structuralIndex_.Build( std::string_view( curr_, static_cast<size_t>( end_ - curr_ ) ) );
+  StartDocument();
+  if( !ParseText() )
+    return false;
+  if( isDocumentOpen_ )
+    EndDocument();
+  return true;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseFile( const std::filesystem::path& path, Handler& handler )
+{
+  YamlFile yamlFile( path );
+  if( !yamlFile.IsOpen() )
+  {
+    YamlError error;
+    error.code = YamlErrorCode::FileOpen;
+    ReportError( handler, error );
+    return false;
+  }
+  BasicYamlParser yamlParser( yamlFile.GetText(), handler );
+  return yamlParser.Parse();
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseParallel( std::string_view yaml,
+                                             const std::function<Handler&( size_t )>& getHandler,
+                                             size_t threadCount )
+{
+  auto docs = Yaml::Detail::SplitDocuments( yaml );
+  std::vector<Handler*> handlers;
+  handlers.reserve( docs.size() );
+  for( size_t i = 0; i < docs.size(); ++i )
+    handlers.push_back( &getHandler( i ) );
+
+  std::vector<uint8_t> results( docs.size() ); // not vector<bool>; written concurrently
+  Yaml::Detail::RunParallel( docs.size(), threadCount, [&]( size_t i )
+  {
+    BasicYamlParser yamlParser( docs[ i ].text, *handlers[ i ] );
+    yamlParser.line_ = docs[ i ].line;
+    yamlParser.baseOffset_ = static_cast<size_t>( docs[ i ].text.data() - yaml.data() );
+    yamlParser.lineStart_ = yamlParser.baseOffset_;
+    results[ i ] = yamlParser.Parse();
+  } );
+  return std::all_of( results.begin(), results.end(), []( uint8_t result ) { return result != 0; } );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseChunked( size_t threadCount )
+{
+  using Yaml::Detail::ChunkRecorder;
+  if( threadCount == 0 )
+    threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+  std::string_view yaml( curr_, static_cast<size_t>( end_ - curr_ ) );
+  bool isSequence = false;
+  auto chunks = Yaml::Detail::SplitTopLevel( yaml, std::min( threadCount * kChunksPerThread,
+                                                             yaml.size() / kMinChunkSize ), isSequence );
+  if( chunks.size() < 2 )
+    return Parse();
+
+  // Parser state at the end of each piece, before closing its collections
+  struct ChunkState
+  {
+    bool   isParsed = false;
+    bool   isComplete = false; // no key awaiting its value
+    Indent entryIndent;        // sequence of top-level entries, if any
+    std::vector<Indent> stack;
+    size_t expandedEvents = 0u;
+    size_t expandedBytes = 0u;
+    size_t parsedEventCount = 0u; // events before the end of the piece closes collections
+    size_t endLine = 0u;
+    size_t endLineStart = 0u;
+  };
+  std::vector<ChunkRecorder> recorders;
+  recorders.reserve( chunks.size() );
+  for( size_t i = 0; i < chunks.size(); ++i )
+    recorders.emplace_back( yaml );
+  std::vector<ChunkState> states( chunks.size() );
+
+  // Pieces are parsed while earlier ones are delivered, which moves this parser
+  const size_t startLine = line_;
+  const size_t startOffset = GetOffset();
+  const size_t startLineStart = lineStart_;
+  auto parseChunk = [&]( size_t i )
+  {
+    BasicYamlParser<ChunkRecorder> chunkParser( chunks[ i ].text, recorders[ i ] );
+    chunkParser.line_ = startLine + chunks[ i ].line - 1;
+    chunkParser.baseOffset_ = startOffset + static_cast<size_t>( chunks[ i ].text.data() - yaml.data() );
+    chunkParser.lineStart_ = ( i == 0 ) ? startLineStart : chunkParser.baseOffset_;
+    chunkParser.maxDepth_ = maxDepth_;
+    chunkParser.maxAliasExpansion_ = maxAliasExpansion_;
+    chunkParser.maxAliasBytes_ = maxAliasBytes_;
+    // No tag registry: tagged scalars are decoded once, as their events are delivered
+    if( useStructuralIndex_ )
+      chunkParser.structuralIndex_.Build( chunks[ i ].text );
+    recorders[ i ].curr_ = &chunkParser.curr_;
+    recorders[ i ].line_ = &chunkParser.line_;
+    recorders[ i ].lineStart_ = &chunkParser.lineStart_;
+
+    auto& state = states[ i ];
+    chunkParser.StartDocument();
+    state.isParsed = chunkParser.ParseText() && !recorders[ i ].HasError() && chunkParser.flowDepth_ == 0;
+    state.isComplete = chunkParser.completeKeyValuePair_;
+    state.entryIndent.level = ( chunkParser.yamlStack_.size() > 1 ) ? chunkParser.yamlStack_[ 1 ].level : 0u;
+    state.entryIndent.isSequence = ( chunkParser.yamlStack_.size() > 1 ) && chunkParser.yamlStack_[ 1 ].isSequence;
+    for( size_t level = 0; level < chunkParser.yamlStack_.size(); ++level )
+      state.stack.push_back( { chunkParser.yamlStack_[ level ].level, chunkParser.yamlStack_[ level ].isSequence } );
+    state.expandedEvents = chunkParser.expandedEvents_;
+    state.expandedBytes = chunkParser.expandedBytes_;
+    state.parsedEventCount = recorders[ i ].GetEvents().size();
+    state.endLine = chunkParser.line_;
+    state.endLineStart = chunkParser.lineStart_;
+    if( state.isParsed )
+      chunkParser.EndDocument();
+  };
+
+  // Reports events [first, last) of a piece. Collections closed by the end of
+  // the piece are closed by Parse() after the indentation of the next piece's
+  // first line.
+  auto emitEvents = [&]( size_t i, size_t first, size_t last )
+  {
+    auto events = recorders[ i ].GetEvents();
+    bool isLast = ( i + 1 == chunks.size() );
+    for( size_t j = first; j < last; ++j )
+    {
+      const auto& event = events[ j ];
+      if( !isLast && j >= states[ i ].parsedEventCount )
+      {
+        auto next = chunks[ i + 1 ].text;
+        curr_ = std::find_if_not( next.data(), next.data() + next.size(), []( char c )
+        {
+          return Yaml::Detail::IsCharClass( c, Yaml::Detail::kIndentClass );
+        } );
+        line_ = states[ i ].endLine;
+        lineStart_ = states[ i ].endLineStart;
+      }
+      else
+      {
+        curr_ = yaml.data() + event.pos;
+        line_ = event.line;
+        lineStart_ = event.lineStart;
+      }
+      if( !EmitEvent( event.type, recorders[ i ].GetText( event ), event.style ) )
+        return false;
+    }
+    return true;
+  };
+
+  // Each piece must end in the state the next one starts from: at the root for
+  // top-level keys, or within the same sequence for entries, which every piece
+  // after the first opens again and every piece before the last closes. Each
+  // piece is delivered once it and the pieces before it are parsed, except for
+  // the collections its end closes, which wait until the next piece is known to
+  // be valid. From the first piece that isn't, the rest of the text is parsed
+  // here, with any errors reported as usual.
+  size_t expandedEvents = 0u;
+  size_t expandedBytes = 0u;
+  size_t invalidChunk = chunks.size();
+  auto deliverChunk = [&]( size_t i )
+  {
+    const auto& state = states[ i ];
+    auto events = recorders[ i ].GetEvents();
+    bool isLast = ( i + 1 == chunks.size() );
+    bool isValid = state.isParsed;
+    if( isSequence )
+    {
+      isValid = isValid && state.entryIndent.isSequence &&
+                state.entryIndent.level == states[ 0 ].entryIndent.level &&
+                ( isLast || ( state.isComplete && !events.empty() && events.back().type == Yaml::Detail::EventType::EndSequence ) ) &&
+                ( i == 0 || ( !events.empty() && events.front().type == Yaml::Detail::EventType::StartSequence ) );
+    }
+    if( !isValid || expandedEvents + state.expandedEvents > maxAliasExpansion_ ||
+        expandedBytes + state.expandedBytes > maxAliasBytes_ )
+    {
+      invalidChunk = i;
+      return false;
+    }
+    expandedEvents += state.expandedEvents;
+    expandedBytes += state.expandedBytes;
+
+    if( i == 0 )
+    {
+      StartDocument();
+    }
+    else
+    {
+      auto previous = recorders[ i - 1 ].GetEvents();
+      size_t last = isSequence ? previous.size() - 1 : previous.size();
+      if( !emitEvents( i - 1, std::min( states[ i - 1 ].parsedEventCount, last ), last ) )
+        return false;
+      recorders[ i - 1 ] = ChunkRecorder( yaml ); // frees its events
+    }
+    size_t first = ( isSequence && i != 0 ) ? 1u : 0u;
+    size_t last = isLast ? events.size() : std::max( first, state.parsedEventCount );
+    if( !emitEvents( i, first, last ) )
+      return false;
+    if( isLast )
+      recorders[ i ] = ChunkRecorder( yaml );
+    return true;
+  };
+
+  if( !Yaml::Detail::RunOrdered( chunks.size(), threadCount, parseChunk, deliverChunk ) )
+  {
+    if( invalidChunk == chunks.size() ) // the handler stopped
+      return false;
+    if( invalidChunk == 0 )
+      return Parse();
+
+    // Resume where the previous piece ended, before closing its collections
+    const auto& state = states[ invalidChunk - 1 ];
+    curr_ = chunks[ invalidChunk ].text.data();
+    line_ = startLine + chunks[ invalidChunk ].line - 1;
+    lineStart_ = GetOffset();
+    yamlStack_.clear();
+    for( auto indent : state.stack )
+      yamlStack_.push( indent );
+    completeKeyValuePair_ = state.isComplete;
+    hasContent_ = true;
+    expandedEvents_ = expandedEvents;
+    expandedBytes_ = expandedBytes;
+    if( !ParseText() )
+      return false;
+    if( isDocumentOpen_ )
+      EndDocument();
+    return true;
+  }
+  curr_ = end_;
+  line_ = states.back().endLine;
+  lineStart_ = states.back().endLineStart;
+  EndDocument();
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseText()
+{
+  assert( curr_ != nullptr && end_ != nullptr );
+  while( curr_ < end_ )
+  {
+    if( !ParseStep() )
+      return false;
+  }
+  return true;
+}
+
+// Handles the character at curr_, along with the rest of its token, then
+// advances to the following character
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseStep()
+{
+  if( GetOffset() == lineStart_ ) // start of line
+  {
+    if( IsDocumentMarker() )
+    {
+      ParseDocumentMarker();
+      ++curr_;
+      return true;
+    }
+    if( IsContentLine() )
+    {
+      if( !isDocumentOpen_ ) // content following "..."
+        StartDocument();
+      hasContent_ = true;
+    }
+
+    // Handle new line indentation
+    auto indent = GetIndent();
+    if( indent.level == Yaml::Detail::kNoLevel )
+      ;
+    else if( indent.level > yamlStack_.top().level )
+    {
+      // "- - x" is an entry of the enclosing sequence holding a new sequence
+      if( indent.isSequence && flowDepth_ == 0 && yamlStack_.top().isSequence &&
+          lineIndent_ < yamlStack_.top().level )
+        EmitEntry();
+      if( !Push( indent ) )
+        return false;
+    }
+    else while( indent.level < yamlStack_.top().level )
+    {
+      if( !Pop() )
+        return false;
+    }
+    if( indent.isSequence && flowDepth_ == 0 && yamlStack_.top().isSequence &&
+        indent.level == yamlStack_.top().level )
+      EmitEntry();
+    if( curr_ == end_ ) // the text ends with indentation
+      return true;
+  }
+  switch( *curr_ )
+  {
+  case '-': // serves multiple purposes
+    switch( PeekNext() )
+    {
+    case ' ': // "- " mapping entry
+      EmitStart( false );
+      SkipSpaces();
+      break;
+    default:  // "-X" node, e.g. "-1234"; "---" is only a marker at the start of a line
+      if( !ParseNode() )
+        return false;
+      break;
+    }
+    break;
+  case ':': // mapping value
+  case ',': // flow collection separator
+    SkipSpaces();
+    break;
+  case '[': // sequence start, e.g. [ one, two, three ]
+    if( IsAtMaxDepth() )
+      return Error( YamlErrorCode::MaxDepth );
+    completeKeyValuePair_ = true;
+    ++flowDepth_;
+    EmitStart( true );
+    SkipSpaces();
+    break;
+  case ']': // sequence end
+    flowDepth_ -= ( flowDepth_ != 0 );
+    HandleMissingNull();
+    EmitEnd( true );
+    SkipSpaces();
+    break;
+  case '{': // mapping start, e.g. { key1: value1, key2 : value2 }
+    if( IsAtMaxDepth() )
+      return Error( YamlErrorCode::MaxDepth );
+    completeKeyValuePair_ = true;
+    ++flowDepth_;
+    EmitStart( false );
+    SkipSpaces();
+    break;
+  case '}': // mapping end
+    flowDepth_ -= ( flowDepth_ != 0 );
+    HandleMissingNull();
+    EmitEnd( false );
+    SkipSpaces();
+    break;
+
+  case '#': // comment
+  case '%': // directive line
+    SkipLine();
+    break;
+  case '\n': // linefeed
+    ++line_;
+    lineStart_ = GetOffset() + 1;
+    break;
+  case '\r': // carriage return
+  case ' ':  // space
+    break;
+  case '\0': // null character: early out
+    end_ = curr_;
+    break;
+  case '\t': // tab
+    return Error( YamlErrorCode::Tab );
+
+  case '|':  // literal block scalar
+  case '>':  // folded block scalar
+    if( !ParseBlock() )
+      return false;
+    break;
+
+  case '&':  // node anchor
+    if( !ParseAnchor() )
+      return false;
+    break;
+  case '*':  // alias
+    if( !ParseAlias() )
+      return false;
+    break;
+
+  case '!':  // tag
+    if( !ParseTag() )
+      return false;
+    break;
+
+  // Characters unsupported by this implementation
+  case '?':  // mapping key
+  case '@':  // reserved
+  case '`':  // reserved
+    return Error( YamlErrorCode::Unsupported, std::string_view( curr_, 1 ) );
+
+  case '\'': // single-quoted scalar
+  case '\"': // double-quoted scalar
+  default:   // everything else
+    if( !ParseNode() )
+      return false;
+    break;
+  }
+  ++curr_;
+  return true;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::StartDocument()
+{
+  yamlHandler_->onStartDocument();
+  isDocumentOpen_ = true;
+  hasContent_ = false;
+  flowDepth_ = 0u;
+  isMuted_ = false;
+  expandedEvents_ = 0u;
+  expandedBytes_ = 0u;
+  anchors_.Clear(); // anchors are local to their document
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::EndDocument()
+{
+  while( yamlStack_.size() > 1 )
+    Pop();
+  HandleMissingNull(); // don't carry a dangling key into the next document
+  yamlHandler_->onEndDocument();
+  isDocumentOpen_ = false;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::Error( YamlErrorCode code, std::string_view detail ) const
+{
+  YamlError error;
+  error.code = code;
+  error.offset = GetOffset();
+  error.line = line_;
+  error.col = GetCol();
+  error.detail = detail;
+  ReportError( *yamlHandler_, error );
+  return false; // all syntax issues are sufficient to quit
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::ReportError( Handler& handler, const YamlError& error )
+{
+  // Only handlers without onErrorCode need the message formatted
+  if constexpr( requires { handler.onErrorCode( error ); } )
+    handler.onErrorCode( error );
+  else
+    handler.onError( error.GetText(), error.line, error.col );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::Push( Indent indent )
+{
+  if( IsAtMaxDepth() )
+    return Error( YamlErrorCode::MaxDepth );
+  completeKeyValuePair_ = true;
+  yamlStack_.push( indent );
+  EmitStart( indent.isSequence );
+  return true;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::Pop()
+{
+  if( yamlStack_.size() == 1 )
+    return Error( YamlErrorCode::UnbalancedClose );
+  HandleMissingNull();
+  EmitEnd( yamlStack_.top().isSequence );
+  yamlStack_.pop();
+  return true;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::IsAtMaxDepth() const
+{
+  // The bottom of the indent stack is the document itself
+  return ( yamlStack_.size() - 1 ) + flowDepth_ >= maxDepth_;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+char BasicYamlParser<Handler>::PeekNext() const
+{
+  return ( curr_ + 1 >= end_ ) ? '\0' : *( curr_ + 1 );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+typename BasicYamlParser<Handler>::Indent BasicYamlParser<Handler>::GetIndent()
+{
+  // Skip all leading spaces and dashes to determine indentation level
+  Indent indent;
+  lineIndent_ = 0u;
+  for( ; curr_ < end_ && Yaml::Detail::IsCharClass( *curr_, Yaml::Detail::kIndentClass ); ++curr_, ++indent.level )
+  {
+    if( *curr_ == '-' )
+      indent.isSequence = true;
+    else if( !indent.isSequence )
+      ++lineIndent_;
+  }
+
+  // If this line doesn't have anything interesting because it's empty or
+  // just a comment, then flag it to be ignored
+  if( curr_ < end_ && Yaml::Detail::IsCharClass( *curr_, Yaml::Detail::kIgnoreLineClass ) )
+    indent.level = Yaml::Detail::kNoLevel;
+
+  return indent;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::IsDocumentMarker() const
+{
+  return Yaml::Detail::IsDocumentMarker( curr_, end_ );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::ParseDocumentMarker()
+{
+  // Three dashes --- signifies the start of a new YAML doc; a leading marker
+  // merely confirms the document that is already open
+  // Three dots ... signifies the end of the current YAML doc
+  if( *curr_ == '-' )
+  {
+    if( isDocumentOpen_ && hasContent_ )
+      EndDocument();
+    if( !isDocumentOpen_ )
+      StartDocument();
+  }
+  else if( isDocumentOpen_ )
+  {
+    EndDocument();
+  }
+
+  // Leave curr_ on the last marker character
+  constexpr size_t kMarkerSize = 3;
+  curr_ += kMarkerSize - 1;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::IsContentLine() const
+{
+  return Yaml::Detail::IsContentLine( curr_, end_ );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::SkipSpaces()
+{
+  for( ++curr_; curr_ < end_ && *curr_ == ' '; ++curr_ )
+    ;
+  --curr_;
+}
+
+// Counts the line ends between start and curr_, which tokens spanning lines
+// such as quoted and block scalars pass over
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::NextLines( const char* start )
+{
+  std::string_view text( start, static_cast<size_t>( curr_ - start ) );
+  if( text.find( '\n' ) == std::string_view::npos ) // typical
+    return;
+  auto lastLineEnd = text.rfind( '\n' );
+  line_ += static_cast<size_t>( std::count( text.begin(), text.begin() + lastLineEnd + 1, '\n' ) );
+  lineStart_ = GetOffset() - ( text.size() - lastLineEnd - 1 );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::SkipLine()
+{
+  if( structuralIndex_.IsBuilt() ) // line ends are indexed
+  {
+    while( ( curr_ = structuralIndex_.FindNext( curr_, end_ ) ) < end_ &&
+           !Yaml::Detail::IsCharClass( *curr_, Yaml::Detail::kEndLineClass ) )
+      ++curr_;
+    --curr_;
+    return;
+  }
+  for( ; curr_ < end_; ++curr_ )
+  {
+    if( Yaml::Detail::IsCharClass( *curr_, Yaml::Detail::kEndLineClass ) )
+    {
+      --curr_;
+      break;
+    }
+  }
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+const char* BasicYamlParser<Handler>::FindEndScalar( const char* curr ) const
+{
+  if( structuralIndex_.IsBuilt() )
+    return structuralIndex_.FindNext( curr, end_ );
+  return Yaml::Detail::FindEndScalar( curr, end_ );
+}
+
+// Skips the value of the key whose ':' is at curr_, leaving curr_ on the last
+// character skipped. Nested content is found by indentation and bracket depth
+// alone; no scalars within it are classified or reported.
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::SkipValue()
+{
+  assert( curr_ < end_ && *curr_ == ':' );
+  size_t lines = 0u;
+  auto next = Yaml::Detail::SkipValue( curr_ + 1, end_, yamlStack_.top().level, flowDepth_ != 0, lines );
+
+  // Anchors within the value may be referenced later, and a value within an
+  // anchored node is replayed by its aliases, so such values are parsed
+  // without reporting their events instead
+  if constexpr( !kHandlesAliases )
+  {
+    if( anchors_.IsRecording() || std::find( curr_, next, '&' ) != next )
+    {
+      isMuted_ = true;
+      muteDepth_ = 0u;
+      return;
+    }
+  }
+  if( lines != 0 )
+  {
+    std::string_view skipped( curr_, static_cast<size_t>( next - curr_ ) );
+    lineStart_ = GetOffset() + skipped.rfind( '\n' ) + 1;
+    line_ += lines;
+  }
+  curr_ = next - 1;
+  completeKeyValuePair_ = true; // a skipped value isn't missing
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::HandleMissingNull()
+{
+  if( !completeKeyValuePair_ )
+  {
+    tagDecoder_ = nullptr; // an empty tagged node has no text to decode
+    EmitScalar( "null", YamlScalarStyle::Plain );
+    completeKeyValuePair_ = true;
+  }
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::IsNormalChar() const
+{
+  // Colons and commas are only special YAML characters when they are 
+  // followed by a space. If not, then treat them as part of the token
+  switch( *curr_ )
+  {
+  case ':':
+  case ',':
+    if( !Yaml::Detail::IsCharClass( PeekNext(), Yaml::Detail::kWhiteClass ) )
+      return true;
+    [[fallthrough]];
+  default:
+    return false;
+  }
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseNode()
+{
+  switch( *curr_ )
+  {
+  case '\'': return ParseQuoted( '\'' );
+  case '\"': return ParseQuoted( '\"' );
+  default:   return ParsePlain();
+  }
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParsePlain() // Unquoted scalar
+{
+  auto startStr = curr_;
+  for( ; ( curr_ = FindEndScalar( curr_ ) ) < end_; ++curr_ ) // find end of scalar
+  {
+    // Potential end; colons and commas may still be part of the scalar
+    if( IsNormalChar() )
+      continue;
+
+    std::string_view str = Yaml::Detail::ExtractStr( startStr, curr_, Yaml::Detail::TrimTrailingBlanks::Yes );
+    return OutputScalar( str, YamlScalarStyle::Plain );
+  }
+  // End of the file
+  completeKeyValuePair_ = true;
+  return EmitScalar( Yaml::Detail::ExtractStr( startStr, curr_, Yaml::Detail::TrimTrailingBlanks::Yes ),
+                     YamlScalarStyle::Plain );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseQuoted(char quote)
+{
+  // skip starting quote
+  auto startStr = ++curr_;
+  bool hasEscapes = false;
+  if( suspension_.tokenOffset == GetOffset() - 1 ) // text up to scanOffset has no closing quote
+  {
+    curr_ = begin_ + ( suspension_.scanOffset - baseOffset_ );
+    hasEscapes = suspension_.hasEscapes;
+  }
+  suspension_.tokenOffset = Suspension::kNone;
+  for( ; ( curr_ = Yaml::Detail::FindEndQuoted( curr_, end_, quote ) ) < end_; ++curr_ ) // find end of scalar
+  {
+    if( *curr_ == '\\' ) // skip the escaped character
+    {
+      hasEscapes = true;
+      if( curr_ + 1 == end_ ) // resume from the backslash
+        break;
+      ++curr_;
+    }
+    else if( quote == '\'' && PeekNext() == '\'' ) // '' is an escaped single quote
+    {
+      hasEscapes = true;
+      ++curr_;
+    }
+    else // found the end
+    {
+      std::string_view str = Yaml::Detail::ExtractStr( startStr, curr_, Yaml::Detail::TrimTrailingBlanks::No );
+
+      // Text without escapes or line breaks is passed straight from the source
+      if( hasEscapes || str.find( '\n' ) != std::string_view::npos )
+      {
+        size_t errPos = 0u;
+        scratch_.clear();
+        if( !Yaml::Detail::DecodeQuoted( str, quote, scratch_, errPos ) )
+        {
+          curr_ = startStr + errPos; // report the position of the escape
+          NextLines( startStr );
+          return Error( YamlErrorCode::InvalidEscape, str.substr( errPos, 2 ) );
+        }
+        str = scratch_;
+      }
+      NextLines( startStr );
+
+      // Skip to next important character to know if this is a key or value
+      curr_ = FindEndScalar( curr_ + 1 );
+      return OutputScalar( str, ( quote == '\'' ) ? YamlScalarStyle::SingleQuoted 
+                                                  : YamlScalarStyle::DoubleQuoted );
+    }
+  }
+  // End of the available text; when streaming, the rest may still arrive.
+  // The token restarts at the opening quote once more text is available, and
+  // its scan resumes where this one stopped.
+  if( !isFinalText_ )
+  {
+    suspension_.scanOffset = GetOffset();
+    suspension_.hasEscapes = hasEscapes;
+    curr_ = startStr - 1;
+    suspension_.tokenOffset = GetOffset();
+    isSuspended_ = true;
+    return false;
+  }
+
+  // End of the YAML but still inside unterminated quoted string
+  // Print out the first few characters of the quoted scalar
+  auto endStr = std::min( end_, startStr + Yaml::Detail::kMaxScalarStringPrefixForErrorMsg );
+  std::string_view str = Yaml::Detail::ExtractStr( startStr-1, endStr, Yaml::Detail::TrimTrailingBlanks::No );
+  curr_ = startStr - 1; // report the position of the opening quote
+  return Error( YamlErrorCode::UnterminatedQuote, str );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseBlock()
+{
+  if( flowDepth_ != 0 )
+    return Error( YamlErrorCode::BlockInFlow );
+  auto style = ( *curr_ == '|' ) ? YamlScalarStyle::Literal : YamlScalarStyle::Folded;
+
+  // When streaming, a block that reached the end of the text so far is only
+  // assembled again once a line ends it; until then, just the new lines are
+  // checked
+  if( suspension_.tokenOffset == GetOffset() && suspension_.blockIndent != 0 && !isFinalText_ )
+  {
+    auto scanned = begin_ + ( suspension_.scanOffset - baseOffset_ );
+    if( Yaml::Detail::FindBlockEnd( scanned, end_, suspension_.blockIndent ) == end_ )
+    {
+      suspension_.scanOffset = baseOffset_ + static_cast<size_t>( end_ - begin_ );
+      isSuspended_ = true;
+      return false;
+    }
+  }
+  suspension_.tokenOffset = Suspension::kNone;
+
+  auto block = Yaml::Detail::ParseBlockScalar( curr_, end_, lineIndent_, scratch_ );
+  if( block.next == nullptr )
+    return Error( YamlErrorCode::InvalidBlockHeader );
+
+  // When streaming, more content lines may follow; resume from the indicator
+  if( block.next == end_ && !isFinalText_ )
+  {
+    suspension_.tokenOffset = GetOffset();
+    suspension_.scanOffset = baseOffset_ + static_cast<size_t>( end_ - begin_ );
+    suspension_.blockIndent = block.indent;
+    isSuspended_ = true;
+    return false;
+  }
+
+  // The scalar is reported at its indicator; continue from the following line
+  completeKeyValuePair_ = true;
+  if( !EmitScalar( block.str, style ) )
+    return false;
+  auto indicator = curr_;
+  curr_ = block.next;
+  NextLines( indicator );
+  --curr_; // caller advances to the next line
+  return true;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::OutputScalar( std::string_view str, YamlScalarStyle style )
+{
+  // Caller must evaluate the current character, hence --
+  bool isKey = ( curr_ < end_ && *curr_ == ':' ); // a quoted scalar may end the text
+  --curr_;
+  if( isKey )
+  {
+    HandleMissingNull(); // handle any imcomplete key/value pairs where there's no value
+    completeKeyValuePair_ = false;
+    switch( EmitKey( str ) )
+    {
+    case YamlKeyAction::Stop:
+      return false;
+    case YamlKeyAction::Skip:
+      ++curr_;
+      SkipValue();
+      break;
+    case YamlKeyAction::Continue:
+      break;
+    }
+    return true;
+  }
+  // else value
+  completeKeyValuePair_ = true;
+  return EmitScalar( str, style );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+std::string_view BasicYamlParser<Handler>::ParseName()
+{
+  // Tags and anchor and alias names end at white space or a flow indicator
+  auto isNameChar = []( char c )
+  {
+    switch( c )
+    {
+    case ',': case '[': case ']': case '{': case '}': case '\t':
+      return false;
+    default:
+      return !Yaml::Detail::IsCharClass( c, Yaml::Detail::kWhiteClass );
+    }
+  };
+  auto startName = curr_ + 1;
+  auto endName = std::find_if_not( startName, end_, isNameChar );
+  curr_ = endName - 1; // caller advances past the name
+  return std::string_view( startName, static_cast<size_t>( endName - startName ) );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseAnchor()
+{
+  auto name = ParseName();
+  if( name.empty() )
+    return Error( YamlErrorCode::MissingAnchorName );
+  if constexpr( requires { yamlHandler_->onAnchor( name ); } )
+  {
+    if( !isMuted_ )
+      yamlHandler_->onAnchor( name );
+  }
+  if constexpr( !kHandlesAliases )
+    anchors_.SetPending( name );
+  return true;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseAlias()
+{
+  auto indicator = curr_; // errors are reported at the '*'
+  auto name = ParseName();
+  if( name.empty() )
+    return Error( YamlErrorCode::MissingAliasName );
+  auto next = std::find_if( curr_ + 1, end_, []( char c ) { return c != ' '; } );
+  if( next < end_ && *next == ':' && ( next + 1 == end_ || Yaml::Detail::IsCharClass( next[ 1 ], Yaml::Detail::kWhiteClass ) ) )
+  {
+    curr_ = indicator;
+    return Error( YamlErrorCode::AliasKey );
+  }
+
+  completeKeyValuePair_ = true;
+  if constexpr( kHandlesAliases )
+  {
+    if( !yamlHandler_->onAlias( name ) )
+    {
+      curr_ = indicator;
+      return Error( YamlErrorCode::UnknownAlias, name );
+    }
+    return true;
+  }
+  else
+  {
+    auto range = anchors_.Find( name );
+    if( range == nullptr )
+    {
+      curr_ = indicator;
+      return Error( YamlErrorCode::UnknownAlias, name );
+    }
+    return Replay( *range );
+  }
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::ParseTag()
+{
+  if( curr_ + 1 < end_ && curr_[ 1 ] == '<' ) // verbatim, e.g. !<tag:yaml.org,2002:str>
+  {
+    auto endTag = std::find( curr_ + 2, end_, '>' );
+    if( endTag == end_ )
+      return Error( YamlErrorCode::UnterminatedVerbatimTag );
+    tag_.assign( curr_ + 2, endTag );
+    curr_ = endTag;
+  }
+  else
+  {
+    // Handles other than "!" and "!!" require %TAG directives, which are ignored
+    auto indicator = curr_;
+    auto suffix = ParseName();
+    if( suffix.starts_with( '!' ) )
+      tag_.assign( Yaml::kCoreTagPrefix ).append( suffix.substr( 1 ) );
+    else if( suffix.find( '!' ) != std::string_view::npos )
+    {
+      curr_ = indicator; // report the tag rather than its end
+      return Error( YamlErrorCode::NamedTagHandle );
+    }
+    else
+      tag_.assign( 1, '!' ).append( suffix );
+  }
+
+  if constexpr( requires { yamlHandler_->onTag( std::string_view( tag_ ) ); } )
+  {
+    if( !isMuted_ )
+      yamlHandler_->onTag( std::string_view( tag_ ) );
+  }
+  if( anchors_.IsRecording() )
+    anchors_.Record( Yaml::Detail::EventType::Tag, tag_ );
+  tagDecoder_ = ( tagRegistry_ != nullptr ) ? tagRegistry_->Find( tag_ ) : nullptr;
+  return true;
+}
+
+// Reports the recorded events of an anchored node again
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::Replay( Yaml::Detail::AnchorRecorder::Range range )
+{
+  using Yaml::Detail::EventType;
+  if( range.count == 0 )
+    return EmitScalar( "null", YamlScalarStyle::Plain );
+  bool isKeyNode = ( anchors_.GetEvent( range.first + range.count - 1 ).type == EventType::Key );
+  for( size_t i = range.first; i < range.first + range.count; ++i )
+  {
+    auto event = anchors_.GetEvent( i );
+    expandedBytes_ += event.textSize;
+    if( ++expandedEvents_ > maxAliasExpansion_ || expandedBytes_ > maxAliasBytes_ )
+      return Error( YamlErrorCode::AliasExpansion );
+    auto type = ( event.type == EventType::Key && isKeyNode ) ? EventType::Scalar // anchored key used as a value
+                                                               : event.type;
+    if( !EmitEvent( type, anchors_.GetText( event ), event.style ) )
+      return false;
+  }
+  return true;
+}
+
+// Reports a recorded event; false if the handler stops parsing
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::EmitEvent( Yaml::Detail::EventType type, std::string_view text,
+                                          YamlScalarStyle style )
+{
+  using Yaml::Detail::EventType;
+  switch( type )
+  {
+  case EventType::StartSequence: EmitStart( true );  break;
+  case EventType::EndSequence:   EmitEnd( true );    break;
+  case EventType::StartMapping:  EmitStart( false ); break;
+  case EventType::EndMapping:    EmitEnd( false );   break;
+  case EventType::Key:
+    switch( EmitKey( text ) )
+    {
+    case YamlKeyAction::Stop:
+      return false;
+    case YamlKeyAction::Skip:
+      isMuted_ = true;
+      muteDepth_ = 0u;
+      break;
+    case YamlKeyAction::Continue:
+      break;
+    }
+    break;
+  case EventType::Scalar:
+    return EmitScalar( text, style );
+  case EventType::Tag:
+    if constexpr( requires { yamlHandler_->onTag( text ); } )
+    {
+      if( !isMuted_ )
+        yamlHandler_->onTag( text );
+    }
+    if( anchors_.IsRecording() )
+      anchors_.Record( EventType::Tag, text );
+    tag_ = text;
+    tagDecoder_ = ( tagRegistry_ != nullptr ) ? tagRegistry_->Find( tag_ ) : nullptr;
+    break;
+  case EventType::Anchor:
+    if constexpr( requires { yamlHandler_->onAnchor( text ); } )
+    {
+      if( !isMuted_ )
+        yamlHandler_->onAnchor( text );
+    }
+    if constexpr( !kHandlesAliases )
+      anchors_.SetPending( text ); // for aliases in text parsed after the pieces
+    break;
+  case EventType::SequenceEntry:
+    EmitEntry();
+    break;
+  }
+  return true;
+}
+
+// All collection, key and scalar events pass through the Emit functions, which
+// record anchored nodes and suppress the events of skipped values. Handlers
+// are called before recording, which may move recorded text being replayed.
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::EmitStart( bool isSequence )
+{
+  tagDecoder_ = nullptr; // tagged collections are passed on as is
+  if( isMuted_ )
+    ++muteDepth_;
+  else
+    isSequence ? yamlHandler_->onStartSequence() : yamlHandler_->onStartMapping();
+  if( anchors_.IsRecording() )
+    anchors_.Record( isSequence ? Yaml::Detail::EventType::StartSequence : Yaml::Detail::EventType::StartMapping );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::EmitEnd( bool isSequence )
+{
+  if( isMuted_ && muteDepth_ != 0 )
+  {
+    isMuted_ = ( --muteDepth_ != 0 );
+  }
+  else
+  {
+    isMuted_ = false; // the skipped value was missing
+    isSequence ? yamlHandler_->onEndSequence() : yamlHandler_->onEndMapping();
+  }
+  if( anchors_.IsRecording() )
+    anchors_.Record( isSequence ? Yaml::Detail::EventType::EndSequence : Yaml::Detail::EventType::EndMapping );
+}
+
+// Block sequence entries aren't collections, so they don't affect muting
+template <typename Handler>
+requires IsYamlHandler<Handler>
+void BasicYamlParser<Handler>::EmitEntry()
+{
+  if constexpr( requires { yamlHandler_->onSequenceEntry(); } )
+  {
+    if( !isMuted_ )
+      yamlHandler_->onSequenceEntry();
+  }
+  if( anchors_.IsRecording() )
+    anchors_.Record( Yaml::Detail::EventType::SequenceEntry );
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+YamlKeyAction BasicYamlParser<Handler>::EmitKey( std::string_view key )
+{
+  auto action = YamlKeyAction::Continue;
+  tagDecoder_ = nullptr;
+  if( !isMuted_ )
+  {
+    if constexpr( std::same_as<decltype( yamlHandler_->onKey( key ) ), YamlKeyAction> )
+      action = yamlHandler_->onKey( key );
+    else if( !yamlHandler_->onKey( key ) )
+      action = YamlKeyAction::Stop;
+  }
+  if( anchors_.IsRecording() )
+    anchors_.Record( Yaml::Detail::EventType::Key, key );
+  return action;
+}
+
+template <typename Handler>
+requires IsYamlHandler<Handler>
+bool BasicYamlParser<Handler>::EmitScalar( std::string_view str, YamlScalarStyle style )
+{
+  if( auto decoder = std::exchange( tagDecoder_, nullptr ); decoder != nullptr )
+  {
+    tagValue_.bytes.clear(); // keeping its capacity
+    tagValue_.time = {};
+    tagValue_.isDate = false;
+    if( !( *decoder )( str, tagValue_ ) )
+      return Error( YamlErrorCode::InvalidTaggedScalar, tag_ );
+    if constexpr( requires { yamlHandler_->onTagged( std::string_view( tag_ ), std::as_const( tagValue_ ) ); } )
+    {
+      if( !isMuted_ )
+        yamlHandler_->onTagged( std::string_view( tag_ ), std::as_const( tagValue_ ) );
+    }
+  }
+
+  bool isContinuing = true;
+  if( isMuted_ )
+    isMuted_ = ( muteDepth_ != 0 );
+  else if constexpr( requires { yamlHandler_->onScalar( str, style ); } )
+    isContinuing = yamlHandler_->onScalar( str, style );
+  else
+    isContinuing = yamlHandler_->onScalar( str );
+  if( anchors_.IsRecording() )
+    anchors_.Record( Yaml::Detail::EventType::Scalar, str, style );
+  return isContinuing;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+extern template class BasicYamlParser<YamlHandler>;
 
 } // end namespace PKIsensee
 